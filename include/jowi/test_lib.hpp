@@ -1,13 +1,68 @@
+#include <source_location>
+#include <span>
+#include <tuple>
+
 #define JOWI_ADD_TEST(name) \
   struct name { \
     void operator()() const; \
   }; \
-  struct name##_initiator { \
-    name##_initiator() { \
-      jowi::test_lib::get_test_context().tests.add_test(name{}); \
-    } \
+  static constinit jowi::test_lib::StaticTestEntry name##_entry = \
+    jowi::test_lib::StaticTestEntry::of<name>(); \
+  static jowi::test_lib::StaticTestRegistration name##_registration{name##_entry}; \
+  void name::operator()() const
+
+/*
+  Declares a test reporting its failure through its return value instead of throwing, type is
+  bool, std::optional<jowi::test_lib::ExceptionInfo> or std::expected<void, E>, e.g.
+  JOWI_ADD_TEST_RESULT(parses_header, std::expected<void, std::string>) { ... return {}; }
+*/
+#define JOWI_ADD_TEST_RESULT(name, type) \
+  struct name { \
+    type operator()() const; \
+  }; \
+  static constinit jowi::test_lib::StaticTestEntry name##_entry = \
+    jowi::test_lib::StaticTestEntry::of<name>(); \
+  static jowi::test_lib::StaticTestRegistration name##_registration{name##_entry}; \
+  type name::operator()() const
+
+/*
+  Declares a property checked on generated arguments, one per generator. The property follows the
+  macro with a const reference parameter per generator, e.g.
+  JOWI_ADD_PROPERTY(sort_keeps_size, jowi::test_lib::vectors_of(...))(const std::vector<int> &v)
+*/
+#define JOWI_ADD_PROPERTY(name, ...) \
+  struct name { \
+    void operator()() const; \
+  }; \
+  static jowi::test_lib::property_function_t<decltype(std::tuple{__VA_ARGS__})> name##_property; \
+  static constinit jowi::test_lib::StaticTestEntry name##_entry = \
+    jowi::test_lib::StaticTestEntry::of<name>(); \
+  static jowi::test_lib::StaticTestRegistration name##_registration{name##_entry}; \
+  void name::operator()() const { \
+    jowi::test_lib::check_property(name##_property, __VA_ARGS__); \
+  } \
+  static void name##_property
+
+/*
+  Declares a fuzz target taking the input as its only parameter, e.g.
+  JOWI_ADD_FUZZ(parse_never_crashes)(std::span<const std::byte> data)
+*/
+#define JOWI_ADD_FUZZ(name) \
+  struct name { \
+    void operator()(std::span<const std::byte> data); \
+  }; \
+  static constinit jowi::test_lib::FuzzEntry name##_entry = \
+    jowi::test_lib::FuzzEntry::of<name>(); \
+  static jowi::test_lib::StaticTestRegistration name##_registration{name##_entry}; \
+  void name::operator()
+
+#define JOWI_ADD_BENCHMARK(name) \
+  struct name { \
+    void operator()() const; \
   }; \
-  static name##_initiator name##_var{}; \
+  static constinit jowi::test_lib::StaticBenchmarkEntry name##_entry = \
+    jowi::test_lib::StaticBenchmarkEntry::of<name>(); \
+  static jowi::test_lib::StaticTestRegistration name##_registration{name##_entry}; \
   void name::operator()() const
 
 #define JOWI_SETUP(argc, argv) \
@@ -0,0 +1,128 @@
+/*
+  Replacement of the global operator new and delete counting every allocation, linked into test
+  executables created with the TRACK_ALLOCATIONS option of jowi_add_test.
+*/
+#include <cstddef>
+#include <cstdlib>
+#include <new>
+#if defined(__APPLE__)
+#include <malloc/malloc.h>
+#else
+#include <malloc.h>
+#endif
+import jowi.test_lib;
+
+namespace test_lib = jowi::test_lib;
+
+namespace {
+  size_t usable_size(void *ptr) {
+#if defined(__APPLE__)
+    return malloc_size(ptr);
+#else
+    return malloc_usable_size(ptr);
+#endif
+  }
+
+  void *try_allocate(size_t n, size_t alignment = 0) noexcept {
+    void *ptr = nullptr;
+    n = n == 0 ? 1 : n;
+    if (alignment <= alignof(std::max_align_t)) {
+      ptr = std::malloc(n);
+    } else if (posix_memalign(&ptr, alignment, n) != 0) {
+      ptr = nullptr;
+    }
+    if (ptr) {
+      test_lib::record_allocation(n, usable_size(ptr));
+    }
+    return ptr;
+  }
+
+  void *allocate(size_t n, size_t alignment = 0) {
+    while (true) {
+      if (void *ptr = try_allocate(n, alignment)) {
+        return ptr;
+      }
+      auto handler = std::get_new_handler();
+      if (!handler) {
+        throw std::bad_alloc{};
+      }
+      handler();
+    }
+  }
+
+  void deallocate(void *ptr) noexcept {
+    if (ptr) {
+      test_lib::record_deallocation(usable_size(ptr));
+      std::free(ptr);
+    }
+  }
+
+  struct AllocationHookInstaller {
+    AllocationHookInstaller() {
+      test_lib::install_allocation_hook();
+    }
+  };
+  AllocationHookInstaller installer;
+}
+
+void *operator new(size_t n) {
+  return allocate(n);
+}
+void *operator new[](size_t n) {
+  return allocate(n);
+}
+void *operator new(size_t n, std::align_val_t al) {
+  return allocate(n, static_cast<size_t>(al));
+}
+void *operator new[](size_t n, std::align_val_t al) {
+  return allocate(n, static_cast<size_t>(al));
+}
+void *operator new(size_t n, const std::nothrow_t &) noexcept {
+  return try_allocate(n);
+}
+void *operator new[](size_t n, const std::nothrow_t &) noexcept {
+  return try_allocate(n);
+}
+void *operator new(size_t n, std::align_val_t al, const std::nothrow_t &) noexcept {
+  return try_allocate(n, static_cast<size_t>(al));
+}
+void *operator new[](size_t n, std::align_val_t al, const std::nothrow_t &) noexcept {
+  return try_allocate(n, static_cast<size_t>(al));
+}
+
+void operator delete(void *ptr) noexcept {
+  deallocate(ptr);
+}
+void operator delete[](void *ptr) noexcept {
+  deallocate(ptr);
+}
+void operator delete(void *ptr, size_t) noexcept {
+  deallocate(ptr);
+}
+void operator delete[](void *ptr, size_t) noexcept {
+  deallocate(ptr);
+}
+void operator delete(void *ptr, std::align_val_t) noexcept {
+  deallocate(ptr);
+}
+void operator delete[](void *ptr, std::align_val_t) noexcept {
+  deallocate(ptr);
+}
+void operator delete(void *ptr, size_t, std::align_val_t) noexcept {
+  deallocate(ptr);
+}
+void operator delete[](void *ptr, size_t, std::align_val_t) noexcept {
+  deallocate(ptr);
+}
+void operator delete(void *ptr, const std::nothrow_t &) noexcept {
+  deallocate(ptr);
+}
+void operator delete[](void *ptr, const std::nothrow_t &) noexcept {
+  deallocate(ptr);
+}
+void operator delete(void *ptr, std::align_val_t, const std::nothrow_t &) noexcept {
+  deallocate(ptr);
+}
+void operator delete[](void *ptr, std::align_val_t, const std::nothrow_t &) noexcept {
+  deallocate(ptr);
+}
@@ -0,0 +1,87 @@
+module;
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+export module jowi.test_lib:alloc;
+
+namespace jowi::test_lib {
+  /*
+    Allocations made through the global operator new during a test. bytes is the total amount of
+    bytes requested, peak_live_bytes is the highest amount of bytes held at once.
+  */
+  export struct AllocStats {
+    uint64_t count;
+    uint64_t bytes;
+    uint64_t peak_live_bytes;
+  };
+
+  /*
+    Plain per thread counters. Every thread only ever touches its own counters, so no atomic
+    operation is needed on the allocation path.
+  */
+  struct AllocCounters {
+    uint64_t count = 0;
+    uint64_t bytes = 0;
+    int64_t live = 0;
+    int64_t peak = 0;
+  };
+
+  constinit thread_local AllocCounters alloc_counters{};
+  constinit std::atomic<bool> alloc_hook_installed = false;
+
+  /*
+    Called by the operator new / delete replacement linked into test executables created with
+    the TRACK_ALLOCATIONS option of jowi_add_test.
+  */
+  export void install_allocation_hook() noexcept {
+    alloc_hook_installed.store(true, std::memory_order_relaxed);
+  }
+  export void record_allocation(size_t requested, size_t usable) noexcept {
+    auto &c = alloc_counters;
+    c.count += 1;
+    c.bytes += requested;
+    c.live += static_cast<int64_t>(usable);
+    c.peak = std::max(c.peak, c.live);
+  }
+  export void record_deallocation(size_t usable) noexcept {
+    alloc_counters.live -= static_cast<int64_t>(usable);
+  }
+
+  /*
+    Returns whether allocations are being counted, i.e. whether the executable was linked with the
+    operator new replacement.
+  */
+  export bool allocation_tracking_enabled() noexcept {
+    return alloc_hook_installed.load(std::memory_order_relaxed);
+  }
+
+  /*
+    Counts the allocations made by the calling thread from construction until stop() is called.
+    Meters can be nested.
+  */
+  export struct AllocMeter {
+    AllocMeter() :
+      __count{alloc_counters.count}, __bytes{alloc_counters.bytes}, __live{alloc_counters.live},
+      __peak{alloc_counters.peak} {
+      alloc_counters.peak = alloc_counters.live;
+    }
+
+    AllocStats stop() const {
+      auto &c = alloc_counters;
+      auto stats = AllocStats{
+        .count = c.count - __count,
+        .bytes = c.bytes - __bytes,
+        .peak_live_bytes = static_cast<uint64_t>(std::max<int64_t>(c.peak - __live, 0))
+      };
+      c.peak = std::max(c.peak, __peak);
+      return stats;
+    }
+
+  private:
+    uint64_t __count;
+    uint64_t __bytes;
+    int64_t __live;
+    int64_t __peak;
+  };
+}
@@ -1,12 +1,23 @@
 module;
 #include <cmath>
+#include <cstdint>
 #include <expected>
+#include <functional>
 #include <format>
+#include <iterator>
 #include <ranges>
 #include <source_location>
+#include <string>
 #include <string_view>
+#include <type_traits>
+#include <utility>
+#include <vector>
 export module jowi.test_lib:assert;
+import :alloc;
+import :close;
 import :exception;
+import :expect;
+import :mismatch;
 
 namespace jowi::test_lib {
   /*
@@ -24,6 +35,37 @@ namespace jowi::test_lib {
     { x < v } -> std::convertible_to<bool>;
   };
 
+  /*
+    The failure message of a comparison of x and y, relation describes how the comparison failed.
+  */
+  template <class T, class V>
+  std::string comparison_failure(
+    const T &x, const V &y, std::string_view relation, const std::source_location &location
+  ) {
+    if constexpr (std::formattable<T, char> && std::formattable<V, char>) {
+      return std::format(
+        "At {} Line {} , {} {} {}",
+        std::string_view{location.file_name()},
+        location.line(),
+        x,
+        relation,
+        y
+      );
+    } else {
+      return std::format(
+        "Assertion error at line {} file {}",
+        location.line(),
+        std::string_view{location.file_name()}
+      );
+    }
+  }
+
+  std::string located_failure(std::string_view err_msg, const std::source_location &location) {
+    return std::format(
+      "At {} Line {} , {}", std::string_view{location.file_name()}, location.line(), err_msg
+    );
+  }
+
   /*
     Checks the equality of two values x and y. Throw a FailAssertion exception when the assertion
     fails. When used in the scope of a tester, exception will be caught and will invalidate the
@@ -34,25 +76,7 @@ namespace jowi::test_lib {
     const T &x, const V &y, const std::source_location &location = std::source_location::current()
   ) {
     if (x != y) {
-      if constexpr (std::formattable<T, char> && std::formattable<V, char>) {
-        throw FailAssertion(
-          std::format(
-            "At {} Line {} , {} is not equal to {}",
-            std::string_view{std::string_view{location.file_name()}},
-            location.line(),
-            x,
-            y
-          )
-        );
-      } else {
-        throw FailAssertion(
-          std::format(
-            "Assertion error at line {} file {}",
-            location.line(),
-            std::string_view{location.file_name()}
-          )
-        );
-      }
+      throw FailAssertion(comparison_failure(x, y, "is not equal to", location));
     }
   }
 
@@ -64,25 +88,7 @@ namespace jowi::test_lib {
     const T &x, const V &y, const std::source_location &location = std::source_location::current()
   ) {
     if (x == y) {
-      if constexpr (std::formattable<T, char> && std::formattable<V, char>) {
-        throw FailAssertion(
-          std::format(
-            "At {} Line {} , {} is equal to {}",
-            std::string_view{location.file_name()},
-            location.line(),
-            x,
-            y
-          )
-        );
-      } else {
-        throw FailAssertion(
-          std::format(
-            "Assertion error at line {} file {}",
-            location.line(),
-            std::string_view{location.file_name()}
-          )
-        );
-      }
+      throw FailAssertion(comparison_failure(x, y, "is equal to", location));
     }
   }
 
@@ -96,61 +102,270 @@ namespace jowi::test_lib {
     const T &x, const V &y, const std::source_location &location = std::source_location::current()
   ) {
     if (x >= y) {
-      if constexpr (std::formattable<T, char> && std::formattable<V, char>) {
-        throw FailAssertion(
-          std::format(
-            "At {} Line {} , {} is not less than {}",
-            std::string_view{location.file_name()},
-            location.line(),
-            x,
-            y
-          )
-        );
+      throw FailAssertion(comparison_failure(x, y, "is not less than", location));
+    }
+  }
+
+  /*
+    Runs the assertion on an element, adding the index of the element to its failure.
+  */
+  template <std::invocable F> void assert_at_index(size_t idx, F &&f) {
+    try {
+      std::invoke(std::forward<F>(f));
+    } catch (const FailAssertion &e) {
+      throw FailAssertion(std::format("{} at index {}", e.msg(), idx));
+    }
+  }
+
+  template <class T, class V>
+  void assert_same_size(const T &x, const V &y, const std::source_location &location) {
+    if (std::ranges::size(x) != std::ranges::size(y)) {
+      throw FailAssertion(
+        std::format(
+          "At {} Line {} , the ranges have sizes {} and {}",
+          std::string_view{location.file_name()},
+          location.line(),
+          std::ranges::size(x),
+          std::ranges::size(y)
+        )
+      );
+    }
+  }
+
+  [[noreturn]] void fail_different_sizes(size_t idx, const std::source_location &location) {
+    throw FailAssertion(
+      std::format(
+        "At {} Line {} , the ranges have different sizes, the shorter one ends at index {}",
+        std::string_view{location.file_name()},
+        location.line(),
+        idx
+      )
+    );
+  }
+
+  /*
+    Opts a range assertion into collecting its mismatches : instead of failing on the first
+    mismatch, the whole ranges are compared and the failure summarizes every mismatch in a message
+    whose size does not depend on the size of the ranges.
+  */
+  export struct CollectMismatches {
+    /*
+      The amount of mismatches described at the start and at the end of the ranges.
+    */
+    size_t keep = 5;
+    /*
+      The amount of mismatching regions listed, a region is a run of consecutive mismatches.
+    */
+    size_t max_regions = 8;
+  };
+
+  /*
+    The bounded statistics of a range assertion in collect mode : the amount of mismatches, the
+    first and last few of them and the first regions of consecutive mismatches with the longest
+    one. The location prefix of the element failures is dropped as it is the same for all of them.
+  */
+  class MismatchSummary {
+    using region = std::pair<size_t, size_t>;
+    CollectMismatches __config;
+    std::source_location __location;
+    std::string __prefix;
+    size_t __count;
+    std::vector<std::pair<size_t, std::string>> __first;
+    /*
+      The mismatches after the first ones, __last[(__count - keep) % keep] is the oldest one once
+      the buffer is full.
+    */
+    std::vector<std::pair<size_t, std::string>> __last;
+    std::vector<region> __regions;
+    size_t __region_count;
+    region __current;
+    region __longest;
+
+  public:
+    MismatchSummary(CollectMismatches config, const std::source_location &location) :
+      __config{config}, __location{location},
+      __prefix{std::format("At {} Line {} , ", location.file_name(), location.line())},
+      __count{0}, __region_count{0}, __current{0, 0}, __longest{0, 0} {
+      __first.reserve(config.keep);
+      __last.reserve(config.keep);
+      __regions.reserve(config.max_regions);
+    }
+
+    void add(size_t idx, std::string_view msg) {
+      if (msg.starts_with(__prefix)) {
+        msg.remove_prefix(__prefix.size());
+      }
+      if (__count < __config.keep) {
+        __first.emplace_back(idx, msg);
+      } else if (__last.size() < __config.keep) {
+        __last.emplace_back(idx, msg);
+      } else if (__config.keep != 0) {
+        auto &oldest = __last[(__count - __config.keep) % __config.keep];
+        oldest.first = idx;
+        oldest.second.assign(msg);
+      }
+      __count += 1;
+
+      if (__region_count != 0 && __current.second == idx) {
+        __current.second += 1;
       } else {
-        throw FailAssertion(
-          std::format(
-            "Assertion error at line {} file {}",
-            location.line(),
-            std::string_view{location.file_name()}
-          )
+        __current = region{idx, idx + 1};
+        __region_count += 1;
+      }
+      if (__region_count <= __config.max_regions) {
+        if (__regions.size() < __region_count) {
+          __regions.push_back(__current);
+        } else {
+          __regions.back() = __current;
+        }
+      }
+      if (__current.second - __current.first > __longest.second - __longest.first) {
+        __longest = __current;
+      }
+    }
+
+    bool empty() const {
+      return __count == 0;
+    }
+
+    /*
+      Fails with the summary when a mismatch was added. compared is the amount of pairs compared,
+      different_sizes tells that one range continues after the other ended.
+    */
+    void check(size_t compared, bool different_sizes) const {
+      if (__count == 0) {
+        return;
+      }
+      std::string msg = __prefix;
+      auto out = std::back_inserter(msg);
+      std::format_to(
+        out, "{} of {} elements do not match in {} regions", __count, compared, __region_count
+      );
+      for (size_t i = 0; i < __regions.size(); i += 1) {
+        const auto &[beg, end] = __regions[i];
+        std::format_to(out, "{}[{}, {})", i == 0 ? " : " : " ", beg, end);
+      }
+      if (!__regions.empty() && __region_count > __regions.size()) {
+        std::format_to(out, " and {} more", __region_count - __regions.size());
+      }
+      std::format_to(out, ", the longest is [{}, {})", __longest.first, __longest.second);
+      if (different_sizes) {
+        std::format_to(
+          out, ", the ranges have different sizes, the shorter one ends at index {}", compared
         );
       }
+      for (const auto &[idx, element_msg] : __first) {
+        std::format_to(out, "\n  index {} : {}", idx, element_msg);
+      }
+      if (__count > __first.size() + __last.size()) {
+        std::format_to(out, "\n  ... {} more", __count - __first.size() - __last.size());
+      }
+      // The oldest of the last mismatches is the next one to be overwritten.
+      size_t oldest = __last.size() == __config.keep && __config.keep != 0
+        ? (__count - __config.keep) % __config.keep
+        : 0;
+      for (size_t i = 0; i < __last.size(); i += 1) {
+        const auto &[idx, element_msg] = __last[(oldest + i) % __last.size()];
+        std::format_to(out, "\n  index {} : {}", idx, element_msg);
+      }
+      throw FailAssertion(std::move(msg));
+    }
+  };
+
+  /*
+    Comparisons of the elements of T and V, called with the location of the assertion if they
+    accept it.
+  */
+  template <class F, class T, class V>
+  concept pairwise_comparison =
+    std::invocable<F, std::ranges::range_value_t<T>, std::ranges::range_value_t<V>> ||
+    std::invocable<
+      F,
+      std::ranges::range_value_t<T>,
+      std::ranges::range_value_t<V>,
+      std::source_location>;
+
+  template <class T, class V, class F, class X, class Y>
+  void compare_pair(F &comp, X &&x, Y &&y, const std::source_location &location) {
+    if constexpr (std::invocable<F, std::ranges::range_value_t<T>, std::ranges::range_value_t<V>>) {
+      comp(std::forward<X>(x), std::forward<Y>(y));
+    } else {
+      comp(std::forward<X>(x), std::forward<Y>(y), location);
     }
   }
 
+  /*
+    Applies comp to the elements of x and y pairwise. Fails when the ranges differ in size,
+    upfront for sized ranges and otherwise once the shorter range ends.
+  */
   export template <std::ranges::input_range T, std::ranges::input_range V, typename F>
-    requires(
-      std::invocable<F, std::ranges::range_value_t<T>, std::ranges::range_value_t<V>> ||
-      std::invocable<
-        F,
-        std::ranges::range_value_t<T>,
-        std::ranges::range_value_t<V>,
-        std::source_location>
-    )
+    requires(pairwise_comparison<F, T, V>)
+  void assert_func(
+    const T &x,
+    const V &y,
+    F &&comp,
+    const std::source_location &location = std::source_location::current()
+  ) {
+    if constexpr (std::ranges::sized_range<const T> && std::ranges::sized_range<const V>) {
+      assert_same_size(x, y, location);
+    }
+    size_t idx = 0;
+    auto x_it = std::ranges::begin(x);
+    auto y_it = std::ranges::begin(y);
+    for (; x_it != std::ranges::end(x) && y_it != std::ranges::end(y); ++x_it, ++y_it) {
+      assert_at_index(idx, [&]() { compare_pair<T, V>(comp, *x_it, *y_it, location); });
+      idx += 1;
+    }
+    if (x_it != std::ranges::end(x) || y_it != std::ranges::end(y)) {
+      fail_different_sizes(idx, location);
+    }
+  }
+
+  /*
+    The collect mode of assert_func, every pair is compared and the failure summarizes all the
+    mismatches, see CollectMismatches.
+  */
+  export template <std::ranges::input_range T, std::ranges::input_range V, typename F>
+    requires(pairwise_comparison<F, T, V>)
   void assert_func(
     const T &x,
     const V &y,
     F &&comp,
+    CollectMismatches collect,
     const std::source_location &location = std::source_location::current()
   ) {
+    if constexpr (std::ranges::sized_range<const T> && std::ranges::sized_range<const V>) {
+      assert_same_size(x, y, location);
+    }
+    MismatchSummary summary{collect, location};
     size_t idx = 0;
-    for (const auto &[v_x, v_y] : std::ranges::zip_view(x, y)) {
+    auto x_it = std::ranges::begin(x);
+    auto y_it = std::ranges::begin(y);
+    for (; x_it != std::ranges::end(x) && y_it != std::ranges::end(y); ++x_it, ++y_it) {
       try {
-        if constexpr (std::invocable<
-                        F,
-                        std::ranges::range_value_t<T>,
-                        std::ranges::range_value_t<V>>) {
-          comp(v_x, v_y);
-        } else {
-          comp(v_x, v_y, location);
-        }
+        compare_pair<T, V>(comp, *x_it, *y_it, location);
       } catch (const FailAssertion &e) {
-        throw FailAssertion(std::format("{} at index {}", e.msg(), idx));
+        summary.add(idx, e.msg());
       }
       idx += 1;
     }
+    bool different_sizes = x_it != std::ranges::end(x) || y_it != std::ranges::end(y);
+    if (different_sizes && summary.empty()) {
+      fail_different_sizes(idx, location);
+    }
+    summary.check(idx, different_sizes);
   }
 
+  /*
+    Contiguous ranges of the same bitwise comparable type, compared with first_mismatch.
+  */
+  template <class T, class V>
+  concept bitwise_comparable_ranges = std::ranges::contiguous_range<const T> &&
+    std::ranges::sized_range<const T> && std::ranges::contiguous_range<const V> &&
+    std::ranges::sized_range<const V> &&
+    std::same_as<std::ranges::range_value_t<T>, std::ranges::range_value_t<V>> &&
+    bitwise_comparable<std::ranges::range_value_t<T>>;
+
   /*
     Cheks the equality of two containers supporting the ranges paradigm.
   */
@@ -161,14 +376,66 @@ namespace jowi::test_lib {
   void assert_equal(
     const T &x, const V &y, const std::source_location &location = std::source_location::current()
   ) {
-    assert_func(
-      x,
-      y,
-      [](const auto &x, const auto &y, const std::source_location &loc) {
-        assert_equal(x, y, loc);
-      },
-      location
-    );
+    if constexpr (bitwise_comparable_ranges<T, V>) {
+      // Only the first differing element goes through the element assertion, for its message.
+      assert_same_size(x, y, location);
+      auto *x_data = std::ranges::data(x);
+      auto *y_data = std::ranges::data(y);
+      size_t idx = first_mismatch(x_data, y_data, std::ranges::size(x));
+      if (idx != std::ranges::size(x)) {
+        assert_at_index(idx, [&]() { assert_equal(x_data[idx], y_data[idx], location); });
+      }
+    } else {
+      assert_func(
+        x,
+        y,
+        [](const auto &x, const auto &y, const std::source_location &loc) {
+          assert_equal(x, y, loc);
+        },
+        location
+      );
+    }
+  }
+
+  /*
+    The collect mode of the range assert_equal, see CollectMismatches.
+  */
+  export template <std::ranges::input_range T, std::ranges::input_range V>
+    requires(equal_comp<std::ranges::range_value_t<T>, std::ranges::range_value_t<V>>)
+  void assert_equal(
+    const T &x,
+    const V &y,
+    CollectMismatches collect,
+    const std::source_location &location = std::source_location::current()
+  ) {
+    if constexpr (bitwise_comparable_ranges<T, V>) {
+      // Equal stretches are skipped with first_mismatch, only mismatches are formatted.
+      assert_same_size(x, y, location);
+      MismatchSummary summary{collect, location};
+      auto *x_data = std::ranges::data(x);
+      auto *y_data = std::ranges::data(y);
+      size_t size = std::ranges::size(x);
+      for (size_t idx = first_mismatch(x_data, y_data, size); idx != size;) {
+        try {
+          assert_equal(x_data[idx], y_data[idx], location);
+        } catch (const FailAssertion &e) {
+          summary.add(idx, e.msg());
+        }
+        idx += 1;
+        idx += first_mismatch(x_data + idx, y_data + idx, size - idx);
+      }
+      summary.check(size, false);
+    } else {
+      assert_func(
+        x,
+        y,
+        [](const auto &x, const auto &y, const std::source_location &loc) {
+          assert_equal(x, y, loc);
+        },
+        collect,
+        location
+      );
+    }
   }
 
   /*
@@ -188,6 +455,22 @@ namespace jowi::test_lib {
       location
     );
   }
+  export template <std::ranges::input_range T, std::ranges::input_range V>
+    requires(lt_comp<std::ranges::range_value_t<T>, std::ranges::range_value_t<V>>)
+  void assert_lt(
+    const T &x,
+    const V &y,
+    CollectMismatches collect,
+    const std::source_location &location = std::source_location::current()
+  ) {
+    assert_func(
+      x,
+      y,
+      [](const auto &x, const auto &y, const std::source_location &loc) { assert_lt(x, y, loc); },
+      collect,
+      location
+    );
+  }
   /*
     Assert non equality
   */
@@ -207,6 +490,24 @@ namespace jowi::test_lib {
       location
     );
   }
+  export template <std::ranges::input_range T, std::ranges::input_range V>
+    requires(equal_comp<std::ranges::range_value_t<T>, std::ranges::range_value_t<V>>)
+  void assert_not_equal(
+    const T &x,
+    const V &y,
+    CollectMismatches collect,
+    const std::source_location &location = std::source_location::current()
+  ) {
+    assert_func(
+      x,
+      y,
+      [](const auto &x, const auto &y, const std::source_location &loc) {
+        assert_not_equal(x, y, loc);
+      },
+      collect,
+      location
+    );
+  }
 
   /*
     Checks if a statement is true.
@@ -217,11 +518,7 @@ namespace jowi::test_lib {
     const std::source_location &location = std::source_location::current()
   ) {
     if (!expr) {
-      throw FailAssertion(
-        std::format(
-          "At {} Line {} , {}", std::string_view{location.file_name()}, location.line(), err_msg
-        )
-      );
+      throw FailAssertion(located_failure(err_msg, location));
     }
   }
   export void assert_false(
@@ -230,20 +527,128 @@ namespace jowi::test_lib {
     const std::source_location &location = std::source_location::current()
   ) {
     if (expr) {
+      throw FailAssertion(located_failure(err_msg, location));
+    }
+  }
+
+  /*
+    Floating points are compared in their common type, integers as doubles.
+  */
+  template <class T, class V>
+  using close_type = std::conditional_t<
+    std::floating_point<std::common_type_t<T, V>>,
+    std::common_type_t<T, V>,
+    double>;
+
+  template <class T, class V>
+  std::string close_failure(
+    T x, V y, Tolerance tol, double error, const std::source_location &location
+  ) {
+    return std::format(
+      "At {} Line {} , {} is not close to {}, {} error {} exceeds {}",
+      std::string_view{location.file_name()},
+      location.line(),
+      x,
+      y,
+      tol.name(),
+      error,
+      tol.value
+    );
+  }
+
+  /*
+    Checks that x and y are close within tol, see Tolerance. A plain number is an absolute
+    tolerance.
+  */
+  export template <class T, class V>
+    requires(std::is_arithmetic_v<T> && std::is_arithmetic_v<V>)
+  void assert_close(
+    T x,
+    V y,
+    Tolerance tol = 1e-6,
+    const std::source_location &location = std::source_location::current()
+  ) {
+    auto e = close_error(static_cast<close_type<T, V>>(x), static_cast<close_type<T, V>>(y), tol);
+    if (e.out) {
+      throw FailAssertion(close_failure(x, y, tol, e.error, location));
+    }
+  }
+
+  /*
+    Checks that two ranges of floating points are close pair by pair within tol, in a single
+    pass. The failure reports how many pairs are not close and the pair with the largest error.
+    Contiguous ranges of the same float or double type are compared with a vectorized kernel.
+  */
+  export template <std::ranges::input_range T, std::ranges::input_range V>
+    requires(
+      std::floating_point<std::ranges::range_value_t<T>> &&
+      std::floating_point<std::ranges::range_value_t<V>>
+    )
+  void assert_close(
+    const T &x,
+    const V &y,
+    Tolerance tol = 1e-6,
+    const std::source_location &location = std::source_location::current()
+  ) {
+    using value_type = close_type<std::ranges::range_value_t<T>, std::ranges::range_value_t<V>>;
+    CloseStats stats;
+    size_t size = 0;
+    value_type worst_x = 0;
+    value_type worst_y = 0;
+    if constexpr (
+      std::ranges::contiguous_range<const T> && std::ranges::sized_range<const T> &&
+      std::ranges::contiguous_range<const V> && std::ranges::sized_range<const V> &&
+      std::same_as<std::ranges::range_value_t<T>, std::ranges::range_value_t<V>> &&
+      lane_float<std::ranges::range_value_t<T>>
+    ) {
+      assert_same_size(x, y, location);
+      size = std::ranges::size(x);
+      stats = close_stats(std::ranges::data(x), std::ranges::data(y), size, tol);
+      if (stats.out_of_tolerance != 0) {
+        worst_x = std::ranges::data(x)[stats.worst_index];
+        worst_y = std::ranges::data(y)[stats.worst_index];
+      }
+    } else {
+      if constexpr (std::ranges::sized_range<const T> && std::ranges::sized_range<const V>) {
+        assert_same_size(x, y, location);
+      }
+      auto x_it = std::ranges::begin(x);
+      auto y_it = std::ranges::begin(y);
+      for (; x_it != std::ranges::end(x) && y_it != std::ranges::end(y); ++x_it, ++y_it) {
+        auto v_x = static_cast<value_type>(*x_it);
+        auto v_y = static_cast<value_type>(*y_it);
+        auto e = close_error(v_x, v_y, tol);
+        merge_error(stats, size, e);
+        if (stats.worst_index == size && e.error != 0) {
+          worst_x = v_x;
+          worst_y = v_y;
+        }
+        size += 1;
+      }
+      if (x_it != std::ranges::end(x) || y_it != std::ranges::end(y)) {
+        fail_different_sizes(size, location);
+      }
+    }
+    if (stats.out_of_tolerance != 0) {
       throw FailAssertion(
         std::format(
-          "At {} Line {} , {}", std::string_view{location.file_name()}, location.line(), err_msg
+          "At {} Line {} , {} of {} elements are not close, the worst at index {} : {} is not "
+          "close to {}, {} error {} exceeds {}",
+          std::string_view{location.file_name()},
+          location.line(),
+          stats.out_of_tolerance,
+          size,
+          stats.worst_index,
+          worst_x,
+          worst_y,
+          tol.name(),
+          stats.max_error,
+          tol.value
         )
       );
     }
   }
 
-  export void assert_close(double x, double y, double tolerance = 1e-6) {
-    if (std::abs(x - y) > tolerance) {
-      throw FailAssertion(std::format("{} {} are not close within {}", x, y, tolerance));
-    }
-  }
-
   export template <typename T, typename E>
   void assert_expected(
     const std::expected<T, E> &e, const std::source_location &loc = std::source_location::current()
@@ -289,14 +694,132 @@ namespace jowi::test_lib {
     }
   }
 
-  template <std::floating_point number_type>
-  void assert_close(
-    number_type l,
-    number_type r,
-    number_type tol = 1e-6,
-    const std::source_location &loc = std::source_location::current()
+  /*
+    Checks that calling f allocates at most n times through the global operator new on the
+    calling thread. Requires the executable to be created with the TRACK_ALLOCATIONS option of
+    jowi_add_test, otherwise the assertion fails.
+  */
+  export template <std::invocable F>
+  void assert_max_allocs(
+    uint64_t n, F &&f, const std::source_location &loc = std::source_location::current()
+  ) {
+    test_lib::assert_true(
+      allocation_tracking_enabled(),
+      "allocation tracking is not enabled, add TRACK_ALLOCATIONS to jowi_add_test",
+      loc
+    );
+    auto meter = AllocMeter{};
+    std::invoke(std::forward<F>(f));
+    auto stats = meter.stop();
+    if (stats.count > n) {
+      throw FailAssertion(
+        std::format(
+          "At {} Line {} , expected at most {} allocations, observed {} allocations of {} bytes "
+          "(peak {} live bytes)",
+          std::string_view{loc.file_name()},
+          loc.line(),
+          n,
+          stats.count,
+          stats.bytes,
+          stats.peak_live_bytes
+        )
+      );
+    }
+  }
+
+  /*
+    Checks that calling f does not allocate through the global operator new.
+  */
+  export template <std::invocable F>
+  void assert_no_alloc(F &&f, const std::source_location &loc = std::source_location::current()) {
+    assert_max_allocs(0, std::forward<F>(f), loc);
+  }
+
+  /*
+    Records a failed expectation in the test running on the calling thread. Kept out of line and
+    cold, so that an expect_* call inlines to its check and a branch.
+  */
+  [[gnu::cold, gnu::noinline]] void expect_failed(
+    std::string_view err_msg, const std::source_location &location
+  ) {
+    thread_expect_failures().record(located_failure(err_msg, location));
+  }
+  template <class T, class V>
+  [[gnu::cold, gnu::noinline]] void expect_failed(
+    const T &x, const V &y, std::string_view relation, const std::source_location &location
   ) {
-    number_type rms_diff = std::sqrt((l - r) * (l - r));
-    assert_lt(rms_diff, tol, loc);
+    thread_expect_failures().record(comparison_failure(x, y, relation, location));
+  }
+
+  /*
+    The soft counterparts of the assertions : a failed expectation is recorded without throwing
+    and the test goes on, it fails once it returns, listing every failed expectation. They return
+    whether the expectation held. Expectations have to be checked on the thread running the test,
+    failures on other threads are not reported.
+  */
+  export template <typename T, equal_comp<T> V>
+  bool expect_equal(
+    const T &x, const V &y, const std::source_location &location = std::source_location::current()
+  ) {
+    if (x != y) [[unlikely]] {
+      expect_failed(x, y, "is not equal to", location);
+      return false;
+    }
+    return true;
+  }
+  export template <typename T, equal_comp<T> V>
+  bool expect_not_equal(
+    const T &x, const V &y, const std::source_location &location = std::source_location::current()
+  ) {
+    if (x == y) [[unlikely]] {
+      expect_failed(x, y, "is equal to", location);
+      return false;
+    }
+    return true;
+  }
+  export template <typename T, equal_comp<T> V>
+  bool expect_lt(
+    const T &x, const V &y, const std::source_location &location = std::source_location::current()
+  ) {
+    if (x >= y) [[unlikely]] {
+      expect_failed(x, y, "is not less than", location);
+      return false;
+    }
+    return true;
+  }
+  export bool expect_true(
+    bool expr,
+    std::string_view err_msg = "expr is not true",
+    const std::source_location &location = std::source_location::current()
+  ) {
+    if (!expr) [[unlikely]] {
+      expect_failed(err_msg, location);
+    }
+    return expr;
+  }
+  export bool expect_false(
+    bool expr,
+    std::string_view err_msg = "expr is true",
+    const std::source_location &location = std::source_location::current()
+  ) {
+    if (expr) [[unlikely]] {
+      expect_failed(err_msg, location);
+    }
+    return !expr;
+  }
+  export template <class T, class V>
+    requires(std::is_arithmetic_v<T> && std::is_arithmetic_v<V>)
+  bool expect_close(
+    T x,
+    V y,
+    Tolerance tol = 1e-6,
+    const std::source_location &location = std::source_location::current()
+  ) {
+    auto e = close_error(static_cast<close_type<T, V>>(x), static_cast<close_type<T, V>>(y), tol);
+    if (e.out) [[unlikely]] {
+      thread_expect_failures().record(close_failure(x, y, tol, e.error, location));
+      return false;
+    }
+    return true;
   }
 }
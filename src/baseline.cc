@@ -0,0 +1,164 @@
+module;
+#include <charconv>
+#include <cstdlib>
+#include <filesystem>
+#include <format>
+#include <fstream>
+#include <functional>
+#include <iterator>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+export module jowi.test_lib:Baseline;
+import :DurationStore;
+import :exception;
+import :statistics;
+import :TestEntry;
+
+namespace jowi::test_lib {
+  export struct BaselineConfig {
+    /*
+      A test regresses when its median got slower by more than this fraction.
+    */
+    double threshold = 0.05;
+    /*
+      The significance level of the one sided Mann-Whitney U test.
+    */
+    double alpha = 0.01;
+    /*
+      Distributions with fewer samples on either side cannot be tested meaningfully and are
+      never reported as a regression.
+    */
+    size_t min_samples = 5;
+  };
+
+  /*
+    Stores the timing distribution of every benchmark of a run. The file contains one record per
+    line in the form of '<n> <sample 1> ... <sample n> <test name>' with samples in nanoseconds
+    per iteration. Plain tests run once, their single timing cannot be tested for a significant
+    slowdown, so they are neither stored nor compared.
+  */
+  export struct BaselineStore {
+    BaselineStore() {}
+
+    /*
+      Loads a baseline file. A file that does not exist yields an empty store, malformed lines
+      are ignored.
+    */
+    static BaselineStore load(const std::filesystem::path &path) {
+      BaselineStore store;
+      auto file = std::ifstream{path};
+      std::string line;
+      while (std::getline(file, line)) {
+        const char *end = line.c_str() + line.size();
+        size_t n = 0;
+        auto [ptr, ec] = std::from_chars(line.c_str(), end, n);
+        if (ec != std::errc{}) {
+          continue;
+        }
+        std::vector<double> samples;
+        while (samples.size() < n && ptr != end && *ptr == ' ') {
+          char *sample_end = nullptr;
+          double sample = std::strtod(ptr + 1, &sample_end);
+          if (sample_end == ptr + 1) {
+            break;
+          }
+          samples.push_back(sample);
+          ptr = sample_end;
+        }
+        if (samples.size() != n || ptr == end || *ptr != ' ') {
+          continue;
+        }
+        store.set(std::string_view{ptr + 1, end}, std::move(samples));
+      }
+      return store;
+    }
+
+    void save(const std::filesystem::path &path) const {
+      std::string buf;
+      for (const auto &[name, samples] : __samples) {
+        std::format_to(std::back_inserter(buf), "{}", samples.size());
+        for (double sample : samples) {
+          std::format_to(std::back_inserter(buf), " {}", sample);
+        }
+        std::format_to(std::back_inserter(buf), " {}\n", name);
+      }
+      auto file = std::ofstream{path, std::ios::trunc};
+      file.write(buf.data(), static_cast<std::streamsize>(buf.size()));
+    }
+
+    BaselineStore &set(std::string_view name, std::vector<double> samples) {
+      auto it = __samples.find(name);
+      if (it == __samples.end()) {
+        __samples.emplace(std::string{name}, std::move(samples));
+      } else {
+        it->second = std::move(samples);
+      }
+      return *this;
+    }
+    /*
+      Stores the samples of a benchmark result, results of plain tests are ignored.
+    */
+    BaselineStore &set(std::string_view name, const TestResult &res) {
+      if (!res.benchmark()) {
+        return *this;
+      }
+      return set(name, res.benchmark()->samples);
+    }
+
+    std::optional<std::reference_wrapper<const std::vector<double>>> get(
+      std::string_view name
+    ) const {
+      auto it = __samples.find(name);
+      if (it == __samples.end()) {
+        return std::nullopt;
+      }
+      return std::cref(it->second);
+    }
+
+    /*
+      Compares a benchmark result against its baseline. Returns the failure describing the
+      regression, or std::nullopt when the result is not a benchmark, has no baseline or did not
+      get significantly slower.
+    */
+    std::optional<ExceptionInfo> compare(
+      std::string_view name, const TestResult &res, const BaselineConfig &config = BaselineConfig{}
+    ) const {
+      auto base = get(name);
+      if (!base || !res.benchmark()) {
+        return std::nullopt;
+      }
+      const auto &current = res.benchmark()->samples;
+      if (base->get().size() < config.min_samples || current.size() < config.min_samples) {
+        return std::nullopt;
+      }
+      double base_median = median(base->get());
+      double current_median = median(current);
+      double slowdown = base_median <= 0 ? 0 : current_median / base_median - 1;
+      double p = mann_whitney_greater(base->get(), current);
+      if (slowdown <= config.threshold || p >= config.alpha) {
+        return std::nullopt;
+      }
+      return ExceptionInfo{
+        std::string{performance_regression},
+        std::format(
+          "median went from {:.2f} ns to {:.2f} ns ({:+.1f}%, threshold {:.1f}%, p = {:.2g})",
+          base_median,
+          current_median,
+          slowdown * 100,
+          config.threshold * 100,
+          p
+        )
+      };
+    }
+
+    size_t size() const {
+      return __samples.size();
+    }
+
+  private:
+    std::unordered_map<std::string, std::vector<double>, StringHash, std::equal_to<>> __samples;
+  };
+}
@@ -0,0 +1,293 @@
+module;
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <concepts>
+#include <cstddef>
+#include <exception>
+#include <format>
+#include <optional>
+#include <source_location>
+#include <string>
+#include <string_view>
+#include <type_traits>
+#include <utility>
+#include <vector>
+export module jowi.test_lib:Benchmark;
+import :alloc;
+import :arena;
+import :exception;
+import :expect;
+import :perf;
+import :randomizer;
+import :reflection;
+import :resources;
+import :statistics;
+import :TestEntry;
+
+namespace jowi::test_lib {
+  /*
+    Prevents the compiler from optimizing away the computation of value.
+  */
+  export template <class T> void do_not_optimize(const T &value) {
+#if defined(__GNUC__) || defined(__clang__)
+    asm volatile("" : : "r,m"(value) : "memory");
+#else
+    std::atomic_signal_fence(std::memory_order_acq_rel);
+    static_cast<void>(static_cast<const volatile char &>(reinterpret_cast<const char &>(value)));
+#endif
+  }
+  export template <class T> void do_not_optimize(T &value) {
+#if defined(__clang__)
+    asm volatile("" : "+r,m"(value) : : "memory");
+#elif defined(__GNUC__)
+    if constexpr (std::is_trivially_copyable_v<T> && sizeof(T) <= sizeof(void *)) {
+      asm volatile("" : "+m,r"(value) : : "memory");
+    } else {
+      asm volatile("" : "+m"(value) : : "memory");
+    }
+#else
+    std::atomic_signal_fence(std::memory_order_acq_rel);
+    static_cast<void>(static_cast<volatile char &>(reinterpret_cast<char &>(value)));
+#endif
+  }
+
+  /*
+    Forces every pending write to memory to be considered observable.
+  */
+  export void clobber_memory() {
+#if defined(__GNUC__) || defined(__clang__)
+    asm volatile("" : : : "memory");
+#else
+    std::atomic_signal_fence(std::memory_order_acq_rel);
+#endif
+  }
+
+  export struct BenchmarkConfig {
+    /*
+      Time spent running the benchmark before measuring.
+    */
+    std::chrono::nanoseconds warmup = std::chrono::milliseconds{10};
+    /*
+      The iteration count is calibrated such that a single sample takes at least this long.
+    */
+    std::chrono::nanoseconds sample_time = std::chrono::milliseconds{5};
+    size_t samples = 21;
+  };
+
+  using benchmark_clock = std::conditional_t<
+    std::chrono::high_resolution_clock::is_steady,
+    std::chrono::high_resolution_clock,
+    std::chrono::steady_clock>;
+
+  /*
+    The smallest observed cost of reading the clock twice, subtracted from every sample.
+  */
+  std::chrono::nanoseconds timer_overhead() {
+    static const auto overhead = []() {
+      auto best = std::chrono::nanoseconds::max();
+      for (int i = 0; i < 1000; i += 1) {
+        auto beg = benchmark_clock::now();
+        auto end = benchmark_clock::now();
+        best = std::min(best, std::chrono::duration_cast<std::chrono::nanoseconds>(end - beg));
+      }
+      return best;
+    }();
+    return overhead;
+  }
+
+  /*
+    Runs a batch of iterations of a benchmark body and returns the time it took. This loop is the
+    only part of a benchmark instantiated for every body, so that the body is inlined into it.
+  */
+  using BatchThunk = std::chrono::nanoseconds (*)(const void *data, size_t iterations);
+
+  template <class F> std::chrono::nanoseconds run_batch(const void *f, size_t iterations) {
+    const auto &body = *static_cast<const F *>(f);
+    auto beg = benchmark_clock::now();
+    for (size_t i = 0; i < iterations; i += 1) {
+      body();
+    }
+    auto end = benchmark_clock::now();
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(end - beg);
+  }
+
+  /*
+    The arena is reset after every batch, outside of the timed region, so that iterations
+    allocating from it do not grow it without bounds.
+  */
+  std::chrono::nanoseconds run_reset_batch(
+    BatchThunk batch, const void *data, size_t iterations, ArenaScope &arena
+  ) {
+    auto elapsed = batch(data, iterations);
+    arena.reset();
+    return elapsed;
+  }
+
+  /*
+    Returns the timing distribution, and when enabled the hardware counters per iteration counted
+    over every sample.
+  */
+  std::pair<BenchmarkStats, std::optional<PerfCounters>> measure(
+    BatchThunk batch, const void *data, const BenchmarkConfig &config, ArenaScope &arena
+  ) {
+    auto overhead = timer_overhead();
+    auto warmup_end = benchmark_clock::now() + config.warmup;
+    do {
+      run_reset_batch(batch, data, 1, arena);
+    } while (benchmark_clock::now() < warmup_end);
+
+    size_t iterations = 1;
+    while (true) {
+      auto elapsed = run_reset_batch(batch, data, iterations, arena);
+      if (elapsed >= config.sample_time) {
+        break;
+      }
+      double grow = elapsed.count() <= 0
+        ? 10.0
+        : 1.2 * static_cast<double>(config.sample_time.count()) /
+          static_cast<double>(elapsed.count());
+      iterations = static_cast<size_t>(
+        static_cast<double>(iterations) * std::clamp(grow, 2.0, 10.0)
+      );
+    }
+
+    // The counters of the thread are in use by the enclosing test when the run is nested.
+    auto *counters =
+      perf_counters_enabled() && arena.outermost() ? &thread_perf_counters() : nullptr;
+    size_t sample_count = std::max<size_t>(config.samples, 1);
+    std::vector<double> samples;
+    samples.reserve(sample_count);
+    if (counters) {
+      counters->start();
+    }
+    for (size_t s = 0; s < sample_count; s += 1) {
+      auto elapsed = run_reset_batch(batch, data, iterations, arena) - overhead;
+      samples.push_back(
+        std::max(static_cast<double>(elapsed.count()), 0.0) / static_cast<double>(iterations)
+      );
+    }
+    std::optional<PerfCounters> counts;
+    if (counters) {
+      counts = counters->stop().divide(static_cast<double>(sample_count * iterations));
+    }
+    return {BenchmarkStats::from_samples(iterations, std::move(samples)), counts};
+  }
+
+  /*
+    Measures a benchmark and takes the measurements of a test around it, shared by every
+    benchmark. Like a test, the benchmark starts from the seed of its name and fails on failed
+    expectations of the expect_* assertions.
+  */
+  TestResult run_benchmark(
+    std::string_view name, BatchThunk batch, const void *data, const BenchmarkConfig &config
+  ) {
+    auto seed = SeedScope{test_seed(name)};
+    auto expectations = ExpectScope{};
+    auto arena = ArenaScope{};
+    auto meter = ResourceMeter{};
+    auto alloc_meter = AllocMeter{};
+    std::optional<std::pair<BenchmarkStats, std::optional<PerfCounters>>> res;
+    std::optional<ExceptionInfo> err;
+    auto beg = benchmark_clock::now();
+    try {
+      res = measure(batch, data, config, arena);
+    } catch (...) {
+      err = translate_exception(std::current_exception());
+    }
+    auto dur = std::chrono::duration_cast<std::chrono::system_clock::duration>(
+      benchmark_clock::now() - beg
+    );
+    if (auto failed = expectations.take(); failed && err) {
+      err->message += std::format("\n{}", failed->message);
+    } else if (failed) {
+      err = std::move(failed);
+    }
+    auto result = TestResult{dur, std::move(err)};
+    if (res) {
+      result.set_benchmark(std::move(res->first));
+      if (res->second) {
+        result.set_counters(res->second.value());
+      }
+    }
+    if (auto allocs = alloc_meter.stop(); allocation_tracking_enabled()) {
+      result.set_allocations(allocs);
+    }
+    result.set_resources(meter.stop());
+    result.set_arena_high_water_mark(arena.release());
+    return result;
+  }
+
+  /*
+    A test that measures the time taken by a single invocation of F. The invocation is warmed up,
+    repeated enough times per sample for the clock resolution to be irrelevant and sampled
+    multiple times. Failing assertions inside the benchmark fail the entry like in a test.
+  */
+  export template <std::invocable F> struct BenchmarkEntry : public GenericTestEntry {
+  public:
+    BenchmarkEntry(
+      F &&f, std::string_view name = get_type_name<F>(), BenchmarkConfig config = BenchmarkConfig{}
+    ) : __f{f}, __name{name}, __config{config} {}
+
+    std::string_view name() const override {
+      return __name;
+    }
+
+    TestResult run_test() const override {
+      return run_benchmark(__name, &run_batch<F>, &__f, __config);
+    }
+
+  private:
+    F __f;
+    std::string __name;
+    BenchmarkConfig __config;
+  };
+
+  /*
+    A benchmark that is registered without touching the heap, the counterpart of StaticTestEntry
+    declared by JOWI_ADD_BENCHMARK. It holds the name of the benchmark, the batch loop
+    instantiated for its body and where the benchmark is defined.
+  */
+  export struct StaticBenchmarkEntry final : public GenericTestEntry {
+    constexpr StaticBenchmarkEntry(
+      std::string_view name,
+      BatchThunk batch,
+      std::source_location loc,
+      BenchmarkConfig config = BenchmarkConfig{}
+    ) : __name{name}, __batch{batch}, __loc{loc}, __config{config} {}
+
+    /*
+      Creates the entry of a default constructible benchmark, named after its type.
+    */
+    template <std::default_initializable T>
+      requires(std::invocable<const T &>)
+    static constexpr StaticBenchmarkEntry of(
+      std::source_location loc = std::source_location::current()
+    ) {
+      return StaticBenchmarkEntry{
+        get_type_name<T>(),
+        [](const void *, size_t iterations) {
+          const T body{};
+          return run_batch<T>(&body, iterations);
+        },
+        loc
+      };
+    }
+
+    std::string_view name() const override {
+      return __name;
+    }
+    const std::source_location &location() const {
+      return __loc;
+    }
+    TestResult run_test() const override {
+      return run_benchmark(__name, __batch, nullptr, __config);
+    }
+
+  private:
+    std::string_view __name;
+    BatchThunk __batch;
+    std::source_location __loc;
+    BenchmarkConfig __config;
+  };
+}
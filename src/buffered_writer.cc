@@ -0,0 +1,182 @@
+module;
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <cerrno>
+#include <chrono>
+#include <cstddef>
+#include <cstdio>
+#include <filesystem>
+#include <format>
+#include <iterator>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <utility>
+export module jowi.test_lib:BufferedWriter;
+
+namespace jowi::test_lib {
+  bool pwrite_string(int fd, std::string_view data, off_t offset) {
+    while (!data.empty()) {
+      auto n = ::pwrite(fd, data.data(), data.size(), offset);
+      if (n < 0 && errno == EINTR) {
+        continue;
+      } else if (n <= 0) {
+        return false;
+      }
+      data.remove_prefix(static_cast<size_t>(n));
+      offset += n;
+    }
+    return true;
+  }
+
+  bool write_string(int fd, std::string_view data) {
+    while (!data.empty()) {
+      auto n = ::write(fd, data.data(), data.size());
+      if (n < 0 && errno == EINTR) {
+        continue;
+      } else if (n <= 0) {
+        return false;
+      }
+      data.remove_prefix(static_cast<size_t>(n));
+    }
+    return true;
+  }
+
+  /*
+    Buffers report output and writes it out in whole records, so that the destination always ends
+    on a record boundary even if the process dies. A record is written out once the buffer grows
+    past flush_size or flush_interval passed since the last write.
+
+    A trailer, e.g. the closing tags of an XML document, is kept after the written records. For
+    files it is rewritten after every flush so that the file is always complete, for pipes it is
+    only written when the writer is closed.
+  */
+  export struct BufferedWriter {
+    static constexpr size_t flush_size = 64 * 1024;
+    static constexpr std::chrono::milliseconds flush_interval{100};
+
+    /*
+      Creates or truncates the file at path.
+    */
+    static std::optional<BufferedWriter> open(const std::filesystem::path &path) {
+      int fd = ::open(path.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+      if (fd < 0) {
+        return std::nullopt;
+      }
+      struct stat st{};
+      bool seekable = ::fstat(fd, &st) == 0 && S_ISREG(st.st_mode);
+      return BufferedWriter{fd, true, seekable};
+    }
+
+    static BufferedWriter standard_output() {
+      return BufferedWriter{STDOUT_FILENO, false, false};
+    }
+
+    BufferedWriter(BufferedWriter &&o) noexcept :
+      __fd{std::exchange(o.__fd, -1)}, __owned{o.__owned}, __seekable{o.__seekable},
+      __buf{std::move(o.__buf)}, __trailer{std::move(o.__trailer)},
+      __trailer_pending{o.__trailer_pending}, __end{o.__end}, __last_flush{o.__last_flush} {}
+    BufferedWriter &operator=(BufferedWriter &&) = delete;
+    BufferedWriter(const BufferedWriter &) = delete;
+    BufferedWriter &operator=(const BufferedWriter &) = delete;
+    ~BufferedWriter() {
+      close();
+    }
+
+    BufferedWriter &write(std::string_view data) {
+      __buf.append(data);
+      return *this;
+    }
+
+    template <class... Args>
+    BufferedWriter &print(std::format_string<Args...> fmt, Args &&...args) {
+      std::format_to(std::back_inserter(__buf), fmt, std::forward<Args>(args)...);
+      return *this;
+    }
+
+    /*
+      Marks the end of a record, everything written so far may be written out.
+    */
+    void end_record() {
+      if (
+        __buf.size() >= flush_size ||
+        std::chrono::steady_clock::now() - __last_flush >= flush_interval
+      ) {
+        flush();
+      }
+    }
+
+    void flush() {
+      __last_flush = std::chrono::steady_clock::now();
+      if (__fd < 0 || (__buf.empty() && !__trailer_pending)) {
+        return;
+      }
+      if (!__seekable) {
+        std::fflush(stdout);
+        write_string(__fd, __buf);
+        __buf.clear();
+        return;
+      }
+      pwrite_string(__fd, __buf, static_cast<off_t>(__end));
+      __end += __buf.size();
+      __buf.clear();
+      pwrite_string(__fd, __trailer, static_cast<off_t>(__end));
+      ::ftruncate(__fd, static_cast<off_t>(__end + __trailer.size()));
+      __trailer_pending = false;
+    }
+
+    void set_trailer(std::string trailer) {
+      __trailer = std::move(trailer);
+      __trailer_pending = true;
+    }
+
+    /*
+      Overwrites bytes that were already written, only possible for files. Returns whether the
+      bytes were written.
+    */
+    bool write_at(size_t offset, std::string_view data) {
+      if (__fd < 0 || !__seekable || offset + data.size() > __end) {
+        return false;
+      }
+      return pwrite_string(__fd, data, static_cast<off_t>(offset));
+    }
+
+    /*
+      The amount of bytes written so far, including buffered bytes.
+    */
+    size_t size() const {
+      return __end + __buf.size();
+    }
+
+    void close() {
+      if (__fd < 0) {
+        return;
+      }
+      flush();
+      if (!__seekable) {
+        write_string(__fd, __trailer);
+      }
+      if (__owned) {
+        ::close(__fd);
+      }
+      __fd = -1;
+    }
+
+  private:
+    int __fd;
+    bool __owned;
+    bool __seekable;
+    std::string __buf;
+    std::string __trailer;
+    bool __trailer_pending = false;
+    size_t __end = 0;
+    std::chrono::steady_clock::time_point __last_flush;
+
+    BufferedWriter(int fd, bool owned, bool seekable) :
+      __fd{fd}, __owned{owned}, __seekable{seekable},
+      __last_flush{std::chrono::steady_clock::now()} {
+      __buf.reserve(flush_size);
+    }
+  };
+}
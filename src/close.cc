@@ -0,0 +1,285 @@
+module;
+#include <algorithm>
+#include <bit>
+#include <cmath>
+#include <concepts>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <limits>
+#include <string_view>
+#include <type_traits>
+#if defined(__x86_64__) && (defined(__GNUC__) || defined(__clang__))
+#define JOWI_TEST_LIB_CLOSE_AVX2 1
+#endif
+export module jowi.test_lib:close;
+
+namespace jowi::test_lib {
+  export enum struct ToleranceMode { ABSOLUTE, RELATIVE, ULP };
+
+  /*
+    How far apart two floating points may be for assert_close :
+    - absolute, |x - y| <= value.
+    - relative, |x - y| <= value * max(|x|, |y|).
+    - ulps, at most value representable values of the type lie between x and y, -0 and +0 are
+      the same value.
+    A NaN is only close to a NaN and an infinity only to the same infinity, whatever the mode.
+  */
+  export struct Tolerance {
+    ToleranceMode mode;
+    double value;
+
+    /*
+      An absolute tolerance, so that assert_close(x, y, 1e-3) compares absolutely.
+    */
+    constexpr Tolerance(double absolute) : mode{ToleranceMode::ABSOLUTE}, value{absolute} {}
+    constexpr Tolerance(ToleranceMode mode, double value) : mode{mode}, value{value} {}
+
+    static constexpr Tolerance absolute(double value) {
+      return Tolerance{ToleranceMode::ABSOLUTE, value};
+    }
+    static constexpr Tolerance relative(double value) {
+      return Tolerance{ToleranceMode::RELATIVE, value};
+    }
+    static constexpr Tolerance ulps(uint64_t count) {
+      return Tolerance{ToleranceMode::ULP, static_cast<double>(count)};
+    }
+
+    constexpr std::string_view name() const {
+      switch (mode) {
+        case ToleranceMode::ABSOLUTE:
+          return "absolute";
+        case ToleranceMode::RELATIVE:
+          return "relative";
+        default:
+          return "ulp";
+      }
+    }
+  };
+
+  /*
+    The comparison of two sequences of floating points : how many pairs are not close, and the
+    largest error with its index, the first one on ties. The error is in the unit of the
+    tolerance, infinite for NaN and infinity mismatches.
+  */
+  struct CloseStats {
+    size_t out_of_tolerance = 0;
+    size_t worst_index = 0;
+    double max_error = 0;
+  };
+
+  /*
+    Floating points whose ulps are counted on their bit pattern, long double is compared as a
+    double.
+  */
+  template <class T>
+  concept lane_float = std::same_as<T, float> || std::same_as<T, double>;
+
+  template <lane_float T>
+  using float_bits = std::conditional_t<sizeof(T) == sizeof(uint32_t), uint32_t, uint64_t>;
+
+  /*
+    The amount of representable values between x and y, both finite.
+  */
+  template <lane_float T> float_bits<T> ulp_distance(T x, T y) {
+    using bits = float_bits<T>;
+    using signed_bits = std::make_signed_t<bits>;
+    constexpr bits sign = bits{1} << (sizeof(T) * 8 - 1);
+    // Negatives map to minus their magnitude, so that the order of the integers is the order of
+    // the floating points and -0 meets +0.
+    auto ordered = [](bits b) {
+      auto magnitude = static_cast<signed_bits>(b & ~sign);
+      return (b & sign) != 0 ? -magnitude : magnitude;
+    };
+    signed_bits ox = ordered(std::bit_cast<bits>(x));
+    signed_bits oy = ordered(std::bit_cast<bits>(y));
+    return ox >= oy ? static_cast<bits>(ox) - static_cast<bits>(oy)
+                    : static_cast<bits>(oy) - static_cast<bits>(ox);
+  }
+
+  template <lane_float T> float_bits<T> ulp_limit(double value) {
+    constexpr auto max = std::numeric_limits<float_bits<T>>::max();
+    return value >= static_cast<double>(max) ? max : static_cast<float_bits<T>>(value);
+  }
+
+  struct CloseError {
+    double error;
+    bool out;
+  };
+
+  /*
+    The error between x and y in the unit of tol and whether it is out of tolerance.
+  */
+  template <std::floating_point T> CloseError close_error(T x, T y, Tolerance tol) {
+    bool x_nan = std::isnan(x);
+    bool y_nan = std::isnan(y);
+    if (x == y || (x_nan && y_nan)) {
+      return CloseError{0, false};
+    } else if (x_nan || y_nan || std::isinf(x) || std::isinf(y)) {
+      return CloseError{std::numeric_limits<double>::infinity(), true};
+    }
+    if (tol.mode == ToleranceMode::ULP) {
+      if constexpr (lane_float<T>) {
+        auto distance = ulp_distance(x, y);
+        return CloseError{static_cast<double>(distance), distance > ulp_limit<T>(tol.value)};
+      } else {
+        return close_error(static_cast<double>(x), static_cast<double>(y), tol);
+      }
+    }
+    T error = std::abs(x - y);
+    if (tol.mode == ToleranceMode::RELATIVE) {
+      error /= std::max(std::abs(x), std::abs(y));
+    }
+    return CloseError{static_cast<double>(error), error > static_cast<T>(tol.value)};
+  }
+
+  /*
+    Adds the error of the pair at index to stats.
+  */
+  void merge_error(CloseStats &stats, size_t index, CloseError e) {
+    stats.out_of_tolerance += e.out ? 1 : 0;
+    if (e.error > stats.max_error) {
+      stats.max_error = e.error;
+      stats.worst_index = index;
+    }
+  }
+
+  /*
+    Compares x and y 32 bytes at a time with the vector extensions of gcc and clang, the same
+    computation as close_error on every lane. Every lane keeps its own count, largest error and
+    the block it was seen in, they are merged once at the end so the loop has no branch. Always
+    inlined into the dispatched kernels, which compile it for their instruction set.
+  */
+  template <lane_float T, ToleranceMode mode>
+  [[gnu::always_inline]] inline CloseStats close_lanes(
+    const T *x, const T *y, size_t n, Tolerance tol
+  ) {
+    using bits = float_bits<T>;
+    // gcc only applies vector_size to a dependent type through a typedef.
+    typedef T vec __attribute__((vector_size(32)));
+    typedef bits uvec __attribute__((vector_size(32)));
+    using mask = decltype(vec{} < vec{});
+    typedef std::conditional_t<mode == ToleranceMode::ULP, bits, T> error_vec
+      __attribute__((vector_size(32)));
+    constexpr size_t width = sizeof(vec) / sizeof(T);
+    constexpr bits sign = bits{1} << (sizeof(T) * 8 - 1);
+    const uvec magnitude_bits = uvec{} + static_cast<bits>(~sign);
+    const uvec inf_bits = uvec{} + std::bit_cast<bits>(std::numeric_limits<T>::infinity());
+    const vec tol_v = vec{} + static_cast<T>(tol.value);
+    const uvec limit_v = uvec{} + ulp_limit<T>(tol.value);
+    const uvec one = uvec{} + 1;
+
+    error_vec max_error{};
+    uvec max_block{};
+    mask count{};
+    uvec block{};
+    size_t i = 0;
+    for (; i + width <= n; i += width) {
+      vec vx;
+      vec vy;
+      std::memcpy(&vx, x + i, sizeof(vec));
+      std::memcpy(&vy, y + i, sizeof(vec));
+      uvec abs_x = __builtin_bit_cast(uvec, vx) & magnitude_bits;
+      uvec abs_y = __builtin_bit_cast(uvec, vy) & magnitude_bits;
+      mask x_nan = vx != vx;
+      mask y_nan = vy != vy;
+      mask equal = (vx == vy) | (x_nan & y_nan);
+      mask special = x_nan | y_nan | __builtin_bit_cast(mask, abs_x == inf_bits) |
+        __builtin_bit_cast(mask, abs_y == inf_bits);
+      error_vec error;
+      mask out;
+      if constexpr (mode == ToleranceMode::ULP) {
+        using svec = decltype(uvec{} < uvec{});
+        constexpr int shift = sizeof(T) * 8 - 1;
+        // The ordering of ulp_distance, negatives map to minus their magnitude.
+        svec x_sign = __builtin_bit_cast(svec, vx) >> shift;
+        svec y_sign = __builtin_bit_cast(svec, vy) >> shift;
+        auto ox = __builtin_bit_cast(uvec, (__builtin_bit_cast(svec, abs_x) ^ x_sign) - x_sign);
+        auto oy = __builtin_bit_cast(uvec, (__builtin_bit_cast(svec, abs_y) ^ y_sign) - y_sign);
+        svec x_ge = __builtin_bit_cast(svec, ox) >= __builtin_bit_cast(svec, oy);
+        error = x_ge ? ox - oy : oy - ox;
+        error = __builtin_bit_cast(svec, special) ? ~uvec{} : error;
+        error = __builtin_bit_cast(svec, equal) ? uvec{} : error;
+        // A special lane is out whatever the limit, which saturates for huge tolerances.
+        out = __builtin_bit_cast(mask, error > limit_v) | (special & ~equal);
+      } else {
+        vec diff = vx - vy;
+        error = __builtin_bit_cast(vec, __builtin_bit_cast(uvec, diff) & magnitude_bits);
+        if constexpr (mode == ToleranceMode::RELATIVE) {
+          vec fx = __builtin_bit_cast(vec, abs_x);
+          vec fy = __builtin_bit_cast(vec, abs_y);
+          error /= (fx > fy ? fx : fy);
+        }
+        error = special ? vec{} + std::numeric_limits<T>::infinity() : error;
+        error = equal ? vec{} : error;
+        out = (error > tol_v) | (special & ~equal);
+      }
+      count -= out;
+      auto better = error > max_error;
+      max_error = better ? error : max_error;
+      max_block = better ? block : max_block;
+      block += one;
+    }
+
+    CloseStats stats;
+    for (size_t lane = 0; lane < width; lane += 1) {
+      stats.out_of_tolerance += static_cast<size_t>(count[lane]);
+      double error = static_cast<double>(max_error[lane]);
+      if constexpr (mode == ToleranceMode::ULP) {
+        if (max_error[lane] == std::numeric_limits<bits>::max()) {
+          error = std::numeric_limits<double>::infinity();
+        }
+      }
+      size_t index = static_cast<size_t>(max_block[lane]) * width + lane;
+      bool earlier_tie = error == stats.max_error && error != 0 && index < stats.worst_index;
+      if (error > stats.max_error || earlier_tie) {
+        stats.max_error = error;
+        stats.worst_index = index;
+      }
+    }
+    for (; i < n; i += 1) {
+      merge_error(stats, i, close_error(x[i], y[i], tol));
+    }
+    return stats;
+  }
+
+  template <lane_float T, ToleranceMode mode>
+  CloseStats close_stats_portable(const T *x, const T *y, size_t n, Tolerance tol) {
+    return close_lanes<T, mode>(x, y, n, tol);
+  }
+
+#ifdef JOWI_TEST_LIB_CLOSE_AVX2
+  template <lane_float T, ToleranceMode mode>
+  __attribute__((target("avx2"))) CloseStats close_stats_avx2(
+    const T *x, const T *y, size_t n, Tolerance tol
+  ) {
+    return close_lanes<T, mode>(x, y, n, tol);
+  }
+#endif
+
+  template <lane_float T, ToleranceMode mode>
+  CloseStats close_stats_dispatch(const T *x, const T *y, size_t n, Tolerance tol) {
+#ifdef JOWI_TEST_LIB_CLOSE_AVX2
+    static const bool has_avx2 = __builtin_cpu_supports("avx2");
+    if (has_avx2) {
+      return close_stats_avx2<T, mode>(x, y, n, tol);
+    }
+#endif
+    return close_stats_portable<T, mode>(x, y, n, tol);
+  }
+
+  /*
+    Compares the n pairs of x and y in a single pass, with AVX2 when the cpu supports it.
+  */
+  template <lane_float T>
+  CloseStats close_stats(const T *x, const T *y, size_t n, Tolerance tol) {
+    switch (tol.mode) {
+      case ToleranceMode::ABSOLUTE:
+        return close_stats_dispatch<T, ToleranceMode::ABSOLUTE>(x, y, n, tol);
+      case ToleranceMode::RELATIVE:
+        return close_stats_dispatch<T, ToleranceMode::RELATIVE>(x, y, n, tol);
+      default:
+        return close_stats_dispatch<T, ToleranceMode::ULP>(x, y, n, tol);
+    }
+  }
+}
@@ -0,0 +1,142 @@
+module;
+#include <algorithm>
+#include <charconv>
+#include <chrono>
+#include <filesystem>
+#include <format>
+#include <fstream>
+#include <functional>
+#include <iterator>
+#include <numeric>
+#include <optional>
+#include <span>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+export module jowi.test_lib:DurationStore;
+
+namespace jowi::test_lib {
+  struct StringHash {
+    using is_transparent = void;
+    size_t operator()(std::string_view v) const {
+      return std::hash<std::string_view>{}(v);
+    }
+  };
+
+  /*
+    Per test durations recorded by previous runs. The file is append only and contains one record
+    per line in the form of '<nanoseconds> <test name>'. When a test appears more than once, the
+    records are averaged with more weight given to recent ones.
+  */
+  export struct DurationStore {
+    DurationStore() {}
+
+    /*
+      Loads a duration file. A file that does not exist yields an empty store, malformed lines
+      are ignored.
+    */
+    static DurationStore load(const std::filesystem::path &path) {
+      DurationStore store;
+      auto file = std::ifstream{path};
+      std::string line;
+      while (std::getline(file, line)) {
+        auto sep = line.find(' ');
+        if (sep == std::string::npos || sep + 1 == line.size()) {
+          continue;
+        }
+        int64_t ns = 0;
+        auto [ptr, ec] = std::from_chars(line.data(), line.data() + sep, ns);
+        if (ec != std::errc{} || ptr != line.data() + sep || ns < 0) {
+          continue;
+        }
+        store.add(std::string_view{line}.substr(sep + 1), std::chrono::nanoseconds{ns});
+        store.__records += 1;
+      }
+      return store;
+    }
+
+    /*
+      Appends the durations of run to the file at path and merges them into this store. Once the
+      file holds several times more records than there are tests, it is rewritten with a single
+      record per test.
+    */
+    void commit(const std::filesystem::path &path, const DurationStore &run) {
+      for (const auto &[name, dur] : run.__durations) {
+        add(name, dur);
+      }
+      __records += run.size();
+      if (__records > 4 * size() + 64) {
+        auto tmp = std::filesystem::path{path}.concat(".tmp");
+        write(std::ofstream{tmp, std::ios::trunc}, __durations);
+        std::error_code ec;
+        std::filesystem::rename(tmp, path, ec);
+        __records = size();
+      } else {
+        write(std::ofstream{path, std::ios::app}, run.__durations);
+      }
+    }
+
+    DurationStore &set(std::string_view name, std::chrono::nanoseconds dur) {
+      auto it = __durations.find(name);
+      if (it == __durations.end()) {
+        __durations.emplace(std::string{name}, dur);
+      } else {
+        it->second = dur;
+      }
+      return *this;
+    }
+    DurationStore &add(std::string_view name, std::chrono::nanoseconds dur) {
+      auto it = __durations.find(name);
+      if (it == __durations.end()) {
+        __durations.emplace(std::string{name}, dur);
+      } else {
+        it->second = (it->second + dur) / 2;
+      }
+      return *this;
+    }
+
+    std::optional<std::chrono::nanoseconds> get(std::string_view name) const {
+      auto it = __durations.find(name);
+      if (it == __durations.end()) {
+        return std::nullopt;
+      }
+      return it->second;
+    }
+
+    bool empty() const {
+      return __durations.empty();
+    }
+    size_t size() const {
+      return __durations.size();
+    }
+
+    /*
+      Returns positions in names, ordered such that the longest tests come first. Tests without a
+      record are put first, since nothing is known about them. Ties keep their original order.
+    */
+    std::vector<size_t> longest_first(std::span<const std::string_view> names) const {
+      std::vector<size_t> order(names.size());
+      std::iota(order.begin(), order.end(), 0);
+      std::ranges::stable_sort(order, [&](size_t l, size_t r) {
+        auto l_dur = get(names[l]).value_or(std::chrono::nanoseconds::max());
+        auto r_dur = get(names[r]).value_or(std::chrono::nanoseconds::max());
+        return l_dur > r_dur;
+      });
+      return order;
+    }
+
+  private:
+    std::unordered_map<std::string, std::chrono::nanoseconds, StringHash, std::equal_to<>>
+      __durations;
+    size_t __records = 0;
+
+    template <class Map> static void write(std::ofstream &&file, const Map &durations) {
+      std::string buf;
+      for (const auto &[name, dur] : durations) {
+        std::format_to(std::back_inserter(buf), "{} {}\n", dur.count(), name);
+      }
+      file.write(buf.data(), static_cast<std::streamsize>(buf.size()));
+    }
+  };
+}
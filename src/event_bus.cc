@@ -0,0 +1,257 @@
+module;
+#include <pthread.h>
+#include <atomic>
+#include <chrono>
+#include <concepts>
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <optional>
+#include <span>
+#include <string_view>
+#include <thread>
+#include <type_traits>
+#include <utility>
+#include <variant>
+#include <vector>
+export module jowi.test_lib:EventBus;
+import :exception;
+import :reflection;
+import :TestEntry;
+import :TestShard;
+
+namespace jowi::test_lib {
+  /*
+    The outcome of a whole run, tests not selected by the filters or the shard count as skipped.
+  */
+  export struct RunSummary {
+    size_t passed;
+    size_t failed;
+    size_t skipped;
+    std::chrono::nanoseconds duration;
+    std::optional<TestShard> shard;
+    /*
+      The seed of the run, see random_seed().
+    */
+    uint64_t seed = 0;
+  };
+
+  /*
+    Receives the events of a run, override the events of interest. index is the position of the
+    test in the suite. Events are delivered on a dedicated thread, one at a time and never
+    concurrently. test_finished and test_skipped are delivered in suite order, test_started as
+    tests start, so it may arrive ahead of the results of earlier tests. assertion_failed is
+    delivered right before test_finished for a test that failed an assertion.
+  */
+  export struct TestListener {
+    virtual ~TestListener() = default;
+    virtual void run_started(size_t test_count) {}
+    virtual void test_started(size_t index, std::string_view name) {}
+    virtual void assertion_failed(size_t index, std::string_view name, const ExceptionInfo &e) {}
+    virtual void test_finished(size_t index, std::string_view name, const TestResult &res) {}
+    virtual void test_skipped(size_t index, std::string_view name) {}
+    virtual void run_finished(const RunSummary &summary) {}
+  };
+
+  /*
+    Unbounded multi producer single consumer queue (Vyukov). Producers only perform an atomic
+    exchange, the consumer never blocks producers. A pushed node becomes visible to the consumer
+    once its predecessor is linked, pop() may therefore briefly report empty while a push is in
+    progress.
+  */
+  template <class T> struct MpscQueue {
+    MpscQueue() : __head{&__stub}, __tail{&__stub} {}
+    MpscQueue(const MpscQueue &) = delete;
+    MpscQueue &operator=(const MpscQueue &) = delete;
+    ~MpscQueue() {
+      while (pop()) {
+      }
+      if (__tail != &__stub) {
+        delete __tail;
+      }
+    }
+
+    void push(T value) {
+      auto *node = new Node{std::move(value)};
+      Node *prev = __head.exchange(node, std::memory_order_acq_rel);
+      prev->next.store(node, std::memory_order_release);
+    }
+
+    std::optional<T> pop() {
+      Node *tail = __tail;
+      Node *next = tail->next.load(std::memory_order_acquire);
+      if (next == nullptr) {
+        return std::nullopt;
+      }
+      __tail = next;
+      auto value = std::move(next->value);
+      next->value.reset();
+      if (tail != &__stub) {
+        delete tail;
+      }
+      return value;
+    }
+
+  private:
+    struct Node {
+      std::optional<T> value;
+      std::atomic<Node *> next = nullptr;
+    };
+    Node __stub;
+    std::atomic<Node *> __head;
+    Node *__tail;
+  };
+
+  struct RunStartedEvent {
+    size_t test_count;
+  };
+  struct TestStartedEvent {
+    size_t index;
+    std::string_view name;
+  };
+  struct AssertionFailedEvent {
+    size_t index;
+    std::string_view name;
+    ExceptionInfo error;
+  };
+  struct TestFinishedEvent {
+    size_t index;
+    std::string_view name;
+    TestResult result;
+  };
+  struct TestSkippedEvent {
+    size_t index;
+    std::string_view name;
+  };
+  using TestEvent = std::variant<
+    RunStartedEvent,
+    TestStartedEvent,
+    AssertionFailedEvent,
+    TestFinishedEvent,
+    TestSkippedEvent,
+    RunSummary>;
+
+  /*
+    Held by the reporter thread while it calls into listeners. Forking (see IsolatedRunner) waits
+    for the current event, so the child never inherits a lock taken by a listener, e.g. the one
+    of stdout.
+  */
+  std::mutex &dispatch_mutex() {
+    static std::mutex mut;
+    static std::once_flag registered;
+    std::call_once(registered, []() {
+      ::pthread_atfork(
+        []() { dispatch_mutex().lock(); },
+        []() { dispatch_mutex().unlock(); },
+        []() { dispatch_mutex().unlock(); }
+      );
+    });
+    return mut;
+  }
+
+  /*
+    Fans the events of a run out to listeners on a dedicated reporter thread, so that test
+    threads only pay for an allocation and an atomic exchange per event. Names must outlive the
+    bus, the names of suite entries do.
+  */
+  export struct EventBus {
+    explicit EventBus(std::span<TestListener *const> listeners) :
+      __listeners{listeners.begin(), listeners.end()} {
+      dispatch_mutex();
+      __reporter = std::jthread{[this]() { drain(); }};
+    }
+    EventBus(const EventBus &) = delete;
+    EventBus &operator=(const EventBus &) = delete;
+    ~EventBus() {
+      close();
+    }
+
+    void run_started(size_t test_count) {
+      post(RunStartedEvent{test_count});
+    }
+    void test_started(size_t index, std::string_view name) {
+      post(TestStartedEvent{index, name});
+    }
+    void assertion_failed(size_t index, std::string_view name, ExceptionInfo e) {
+      post(AssertionFailedEvent{index, name, std::move(e)});
+    }
+    void test_finished(size_t index, std::string_view name, TestResult &&res) {
+      if (auto err = res.get_error(); err && err->name == get_type_name<FailAssertion>()) {
+        assertion_failed(index, name, std::move(err.value()));
+      }
+      post(TestFinishedEvent{index, name, std::move(res)});
+    }
+    void test_skipped(size_t index, std::string_view name) {
+      post(TestSkippedEvent{index, name});
+    }
+    void run_finished(const RunSummary &summary) {
+      post(summary);
+    }
+
+    /*
+      Delivers every posted event and stops the reporter thread. No event may be posted
+      afterwards.
+    */
+    void close() {
+      if (!__reporter.joinable()) {
+        return;
+      }
+      __closed.store(true, std::memory_order_release);
+      __posted.fetch_add(1, std::memory_order_release);
+      __posted.notify_one();
+      __reporter.join();
+    }
+
+  private:
+    std::vector<TestListener *> __listeners;
+    MpscQueue<TestEvent> __queue;
+    std::atomic<uint64_t> __posted = 0;
+    std::atomic<bool> __closed = false;
+    std::jthread __reporter;
+
+    void post(TestEvent &&e) {
+      __queue.push(std::move(e));
+      __posted.fetch_add(1, std::memory_order_release);
+      __posted.notify_one();
+    }
+
+    void drain() {
+      while (true) {
+        auto seen = __posted.load(std::memory_order_acquire);
+        bool closed = __closed.load(std::memory_order_acquire);
+        while (auto e = __queue.pop()) {
+          std::lock_guard l{dispatch_mutex()};
+          dispatch(e.value());
+        }
+        if (closed) {
+          return;
+        }
+        __posted.wait(seen, std::memory_order_acquire);
+      }
+    }
+
+    void dispatch(const TestEvent &e) {
+      for (auto *l : __listeners) {
+        std::visit(
+          [&](const auto &event) {
+            using event_type = std::decay_t<decltype(event)>;
+            if constexpr (std::same_as<event_type, RunStartedEvent>) {
+              l->run_started(event.test_count);
+            } else if constexpr (std::same_as<event_type, TestStartedEvent>) {
+              l->test_started(event.index, event.name);
+            } else if constexpr (std::same_as<event_type, AssertionFailedEvent>) {
+              l->assertion_failed(event.index, event.name, event.error);
+            } else if constexpr (std::same_as<event_type, TestFinishedEvent>) {
+              l->test_finished(event.index, event.name, event.result);
+            } else if constexpr (std::same_as<event_type, TestSkippedEvent>) {
+              l->test_skipped(event.index, event.name);
+            } else {
+              l->run_finished(event);
+            }
+          },
+          e
+        );
+      }
+    }
+  };
+}
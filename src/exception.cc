@@ -1,7 +1,13 @@
 module;
+#include <array>
+#include <cstddef>
 #include <exception>
 #include <expected>
+#include <optional>
+#include <span>
+#include <stdexcept>
 #include <string>
+#include <string_view>
 export module jowi.test_lib:exception;
 import :reflection;
 
@@ -36,8 +42,17 @@ namespace jowi::test_lib {
 
     ExceptionInfo(const is_exception auto &e) :
       name{std::string{get_type_name<std::decay_t<decltype(e)>>()}}, message{e.what()} {}
+    ExceptionInfo(std::string name, std::string message) :
+      name{std::move(name)}, message{std::move(message)} {}
   };
 
+  /*
+    The name of the error failing a benchmark that got slower than its baseline, reported as a
+    failure like a FailAssertion rather than as an error.
+  */
+  export constexpr auto performance_regression =
+    std::string_view{"jowi::test_lib::PerformanceRegression"};
+
   export template <is_exception... exceptions> struct ExceptionCatcher;
 
   /*
@@ -87,5 +102,92 @@ namespace jowi::test_lib {
     }
   };
 
-  template <is_exception... exceptions> struct ExceptionPack {};
+  export template <is_exception... exceptions> struct ExceptionPack {};
+
+  /*
+    Turns an exception into an ExceptionInfo when it is of the type handled by the translator,
+    returns std::nullopt otherwise.
+  */
+  export using ExceptionTranslator = std::optional<ExceptionInfo> (*)(const std::exception_ptr &);
+
+  template <is_exception exception_t>
+  std::optional<ExceptionInfo> translate_as(const std::exception_ptr &e) {
+    try {
+      std::rethrow_exception(e);
+    } catch (const exception_t &err) {
+      return ExceptionInfo{err};
+    } catch (...) {
+      return std::nullopt;
+    }
+  }
+
+  /*
+    The exceptions every test catches, translated by translate_exception itself.
+  */
+  template <class exception_t>
+  concept is_default_exception =
+    is_in_values<exception_t, FailAssertion, std::runtime_error, std::exception>;
+
+  /*
+    The amount of exceptions of the pack exception_t derives from. A class always comes after its
+    subclasses when ordered by decreasing depth.
+  */
+  template <class exception_t, class... exceptions>
+  constexpr size_t derivation_depth =
+    ((std::derived_from<exception_t, exceptions> && !std::same_as<exception_t, exceptions>) + ... +
+     0);
+
+  template <is_exception... exceptions> consteval auto make_translators() {
+    constexpr size_t size = (!is_default_exception<exceptions> + ... + 0);
+    std::array<ExceptionTranslator, size> table{};
+    std::array<size_t, size> depths{};
+    size_t count = 0;
+    [[maybe_unused]] auto insert = [&]<class exception_t>() {
+      if constexpr (!is_default_exception<exception_t>) {
+        size_t depth = derivation_depth<exception_t, exceptions...>;
+        size_t i = count;
+        for (; i > 0 && depths[i - 1] < depth; i -= 1) {
+          table[i] = table[i - 1];
+          depths[i] = depths[i - 1];
+        }
+        table[i] = &translate_as<exception_t>;
+        depths[i] = depth;
+        count += 1;
+      }
+    };
+    (insert.template operator()<exceptions>(), ...);
+    return table;
+  }
+
+  /*
+    The translators of a custom exception pack, subclasses are tried before their parents. This
+    table is the only thing instantiated per exception pack, the translation itself is shared by
+    every test.
+  */
+  export template <is_exception... exceptions>
+  constexpr auto exception_translators = make_translators<exceptions...>();
+
+  /*
+    Translates an exception thrown by a test. The translators are tried in order, then
+    FailAssertion, std::runtime_error and std::exception. Exceptions that are none of these are
+    rethrown.
+  */
+  export ExceptionInfo translate_exception(
+    const std::exception_ptr &e, std::span<const ExceptionTranslator> translators = {}
+  ) {
+    for (auto translate : translators) {
+      if (auto info = translate(e)) {
+        return std::move(info.value());
+      }
+    }
+    try {
+      std::rethrow_exception(e);
+    } catch (const FailAssertion &err) {
+      return ExceptionInfo{err};
+    } catch (const std::runtime_error &err) {
+      return ExceptionInfo{err};
+    } catch (const std::exception &err) {
+      return ExceptionInfo{err};
+    }
+  }
 }
\ No newline at end of file
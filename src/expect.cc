@@ -0,0 +1,115 @@
+module;
+#include <cstddef>
+#include <format>
+#include <optional>
+#include <string>
+#include <utility>
+#include <vector>
+export module jowi.test_lib:expect;
+import :exception;
+import :reflection;
+
+namespace jowi::test_lib {
+  export struct ExpectConfig {
+    /*
+      The most failed expectations recorded per test, later ones are only counted.
+    */
+    size_t max_failures = 32;
+  };
+
+  /*
+    The configuration of the expect_* assertions, --max-expect-failures sets the cap.
+  */
+  export ExpectConfig &expect_config() {
+    static ExpectConfig config{};
+    return config;
+  }
+
+  /*
+    The failed expectations of the test running on the calling thread, at most max_failures of
+    them are kept.
+  */
+  class ExpectFailures {
+    std::vector<std::string> __failures;
+    size_t __count = 0;
+
+  public:
+    void reserve(size_t max_failures) {
+      __failures.reserve(max_failures);
+    }
+
+    bool empty() const {
+      return __count == 0;
+    }
+    void clear() {
+      __failures.clear();
+      __count = 0;
+    }
+
+    void record(std::string msg) {
+      if (__failures.size() < expect_config().max_failures) {
+        __failures.emplace_back(std::move(msg));
+      }
+      __count += 1;
+    }
+
+    /*
+      The failures as a single FailAssertion listing every kept failure, nullopt when every
+      expectation held. Clears the failures.
+    */
+    std::optional<ExceptionInfo> take() {
+      if (__count == 0) {
+        return std::nullopt;
+      }
+      std::string msg =
+        std::format("{} {} failed", __count, __count == 1 ? "expectation" : "expectations");
+      for (const auto &failure : __failures) {
+        msg += "\n  ";
+        msg += failure;
+      }
+      if (__count > __failures.size()) {
+        msg += std::format("\n  ... {} more", __count - __failures.size());
+      }
+      clear();
+      return ExceptionInfo{std::string{get_type_name<FailAssertion>()}, std::move(msg)};
+    }
+  };
+
+  ExpectFailures &thread_expect_failures() {
+    thread_local ExpectFailures failures;
+    return failures;
+  }
+
+  /*
+    Records the expectations failed on the calling thread while it lives, into a buffer reserved
+    upfront and reused by the next scopes of the thread. Failures recorded before are set aside
+    and restored afterwards, so a test run from within another test does not see the failures of
+    the other test, nor report its own to it.
+  */
+  class ExpectScope {
+    std::optional<ExpectFailures> __outer;
+
+  public:
+    ExpectScope() {
+      auto &failures = thread_expect_failures();
+      if (!failures.empty()) {
+        __outer.emplace(std::exchange(failures, ExpectFailures{}));
+      }
+      failures.reserve(expect_config().max_failures);
+    }
+    ExpectScope(const ExpectScope &) = delete;
+    ExpectScope &operator=(const ExpectScope &) = delete;
+    ~ExpectScope() {
+      auto &failures = thread_expect_failures();
+      if (__outer) {
+        failures = std::move(__outer.value());
+      } else {
+        failures.clear();
+      }
+    }
+
+    std::optional<ExceptionInfo> take() {
+      return thread_expect_failures().take();
+    }
+  };
+}
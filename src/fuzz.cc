@@ -0,0 +1,623 @@
+module;
+#include <fcntl.h>
+#include <signal.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <exception>
+#include <filesystem>
+#include <format>
+#include <functional>
+#include <memory>
+#include <optional>
+#include <source_location>
+#include <span>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <system_error>
+#include <utility>
+#include <vector>
+export module jowi.test_lib:fuzz;
+import :BufferedWriter;
+import :exception;
+import :expect;
+import :randomizer;
+import :reflection;
+import :TestEntry;
+
+namespace jowi::test_lib {
+  /*
+    The 8 bit edge counters of the modules built with -fsanitize-coverage=inline-8bit-counters,
+    see the FUZZ option of jowi_add_test. The instrumentation registers them before any dynamic
+    initializer runs, hence the constant initialized storage.
+  */
+  struct CounterRegion {
+    uint8_t *beg;
+    uint8_t *end;
+  };
+  constinit std::array<CounterRegion, 64> counter_regions{};
+  constinit size_t counter_region_count = 0;
+}
+
+extern "C" {
+  void __sanitizer_cov_8bit_counters_init(uint8_t *beg, uint8_t *end) {
+    using namespace jowi::test_lib;
+    if (beg != end && counter_region_count < counter_regions.size()) {
+      counter_regions[counter_region_count] = CounterRegion{beg, end};
+      counter_region_count += 1;
+    }
+  }
+
+  // Only defined when linked with a sanitizer runtime.
+  __attribute__((weak)) void __sanitizer_set_death_callback(void (*callback)());
+}
+
+namespace jowi::test_lib {
+  /*
+    The hit count buckets of libFuzzer : 1, 2, 3, 4-7, 8-15, 16-31, 32-127 and 128+.
+  */
+  constexpr uint8_t count_bucket(uint8_t count) {
+    if (count >= 128) {
+      return 128;
+    } else if (count >= 32) {
+      return 64;
+    } else if (count >= 16) {
+      return 32;
+    } else if (count >= 8) {
+      return 16;
+    } else if (count >= 4) {
+      return 8;
+    } else if (count == 3) {
+      return 4;
+    }
+    return count;
+  }
+
+  /*
+    The coverage features seen while fuzzing, a feature is a counter reaching a new bucket.
+  */
+  struct CoverageMap {
+    CoverageMap() {
+      size_t size = 0;
+      for (size_t r = 0; r < counter_region_count; r += 1) {
+        size += static_cast<size_t>(counter_regions[r].end - counter_regions[r].beg);
+      }
+      __seen.assign(size, 0);
+    }
+
+    /*
+      Folds the counters of the last run into the map and zeroes them, returns the amount of new
+      features. Counters are read 8 at a time, edges that were not hit cost a load per 8 edges.
+    */
+    size_t collect() {
+      size_t found = 0;
+      size_t base = 0;
+      for (size_t r = 0; r < counter_region_count; r += 1) {
+        auto [beg, end] = counter_regions[r];
+        size_t size = static_cast<size_t>(end - beg);
+        size_t i = 0;
+        for (; i + sizeof(uint64_t) <= size; i += sizeof(uint64_t)) {
+          uint64_t word;
+          std::memcpy(&word, beg + i, sizeof(word));
+          if (word == 0) {
+            continue;
+          }
+          for (size_t j = i; j < i + sizeof(uint64_t); j += 1) {
+            found += merge(base + j, beg[j]);
+          }
+          std::memset(beg + i, 0, sizeof(word));
+        }
+        for (; i < size; i += 1) {
+          found += merge(base + i, beg[i]);
+          beg[i] = 0;
+        }
+        base += size;
+      }
+      return found;
+    }
+
+    size_t features() const {
+      size_t count = 0;
+      for (uint8_t buckets : __seen) {
+        count += static_cast<size_t>(std::popcount(buckets));
+      }
+      return count;
+    }
+
+  private:
+    std::vector<uint8_t> __seen;
+
+    size_t merge(size_t i, uint8_t count) {
+      uint8_t bucket = count_bucket(count);
+      if (bucket == 0 || (__seen[i] & bucket) != 0) {
+        return 0;
+      }
+      __seen[i] |= bucket;
+      return 1;
+    }
+  };
+
+  /*
+    A file mapped read only into memory. Empty files are not mapped and have empty bytes.
+  */
+  export struct MappedFile {
+    static std::optional<MappedFile> open(const std::filesystem::path &path) {
+      int fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+      if (fd < 0) {
+        return std::nullopt;
+      }
+      struct stat st{};
+      if (::fstat(fd, &st) != 0 || !S_ISREG(st.st_mode)) {
+        ::close(fd);
+        return std::nullopt;
+      }
+      auto size = static_cast<size_t>(st.st_size);
+      void *data = nullptr;
+      if (size != 0) {
+        data = ::mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+      }
+      ::close(fd);
+      if (data == MAP_FAILED) {
+        return std::nullopt;
+      }
+      return MappedFile{data, size};
+    }
+
+    MappedFile(MappedFile &&o) noexcept :
+      __data{std::exchange(o.__data, nullptr)}, __size{std::exchange(o.__size, 0)} {}
+    MappedFile &operator=(MappedFile &&) = delete;
+    MappedFile(const MappedFile &) = delete;
+    MappedFile &operator=(const MappedFile &) = delete;
+    ~MappedFile() {
+      if (__data) {
+        ::munmap(__data, __size);
+      }
+    }
+
+    std::span<const std::byte> bytes() const {
+      return std::span{static_cast<const std::byte *>(__data), __size};
+    }
+
+  private:
+    MappedFile(void *data, size_t size) : __data{data}, __size{size} {}
+    void *__data;
+    size_t __size;
+  };
+
+  export struct FuzzConfig {
+    /*
+      The directory holding the corpus of every fuzz target, one directory per target named after
+      the target. Defaults to '<executable>.corpus'.
+    */
+    std::filesystem::path corpus = "corpus";
+    /*
+      The largest input generated while fuzzing.
+    */
+    size_t max_size = 4096;
+    /*
+      The amount of generated inputs run while fuzzing, 0 runs until an input fails.
+    */
+    size_t runs = 0;
+  };
+
+  /*
+    The configuration of every fuzz target, set by --corpus and --fuzz-runs.
+  */
+  export FuzzConfig &fuzz_config() {
+    static FuzzConfig config{};
+    return config;
+  }
+
+  export struct FuzzFailure {
+    /*
+      Where the failing input was written, replaying the corpus replays it.
+    */
+    std::filesystem::path input;
+    ExceptionInfo error;
+  };
+
+  export struct FuzzReport {
+    size_t runs = 0;
+    size_t corpus_size = 0;
+    /*
+      The coverage features found, always 0 without coverage instrumentation.
+    */
+    size_t features = 0;
+    std::optional<FuzzFailure> failure;
+  };
+
+  using FuzzTarget = void (*)(std::span<const std::byte> data);
+
+  uint64_t input_hash(std::span<const std::byte> data) {
+    uint64_t hash = 0xcbf29ce484222325;
+    for (auto b : data) {
+      hash = (hash ^ static_cast<uint64_t>(b)) * 0x100000001b3;
+    }
+    return hash;
+  }
+
+  /*
+    Writes data into dir/<prefix><hash of data> with async signal safe calls only, path has to be
+    large enough for dir, the prefix and 16 hex digits. Returns whether the input was written.
+  */
+  bool write_input(
+    std::string_view dir,
+    std::string_view prefix,
+    std::span<const std::byte> data,
+    std::span<char> path
+  ) {
+    constexpr std::string_view digits = "0123456789abcdef";
+    if (dir.size() + prefix.size() + 18 > path.size()) {
+      return false;
+    }
+    char *out = std::copy(dir.begin(), dir.end(), path.data());
+    *out++ = '/';
+    out = std::copy(prefix.begin(), prefix.end(), out);
+    uint64_t hash = input_hash(data);
+    for (int shift = 60; shift >= 0; shift -= 4) {
+      *out++ = digits[(hash >> shift) & 0xf];
+    }
+    *out = '\0';
+    int fd = ::open(path.data(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+    if (fd < 0) {
+      return false;
+    }
+    bool written = write_string(
+      fd, std::string_view{reinterpret_cast<const char *>(data.data()), data.size()}
+    );
+    ::close(fd);
+    return written;
+  }
+
+  std::filesystem::path save_input(
+    const std::filesystem::path &dir, std::string_view prefix, std::span<const std::byte> data
+  ) {
+    std::vector<char> path(dir.native().size() + prefix.size() + 18);
+    write_input(dir.native(), prefix, data, path);
+    return std::filesystem::path{path.data()};
+  }
+
+  /*
+    The input being run while fuzzing, written into the corpus as a crash when the process dies
+    of a fatal signal or of a sanitizer report.
+  */
+  constinit std::atomic<const std::byte *> crash_data = nullptr;
+  constinit std::atomic<size_t> crash_size = 0;
+  constinit std::atomic<const char *> crash_dir = nullptr;
+
+  void write_crash() {
+    const std::byte *data = crash_data.exchange(nullptr);
+    const char *dir = crash_dir.load();
+    if (data == nullptr || dir == nullptr) {
+      return;
+    }
+    static char path[4096];
+    if (write_input(dir, "crash-", std::span{data, crash_size.load()}, path)) {
+      constexpr std::string_view msg = "\nCrashing input written to ";
+      write_string(STDERR_FILENO, msg);
+      write_string(STDERR_FILENO, path);
+      write_string(STDERR_FILENO, "\n");
+    }
+  }
+
+  void crash_signal_handler(int sig) {
+    write_crash();
+    ::signal(sig, SIG_DFL);
+    ::raise(sig);
+  }
+
+  /*
+    Installs the crash handlers for its lifetime. Signals already handled, e.g. by a sanitizer,
+    are left alone, the sanitizer death callback covers them.
+  */
+  struct CrashGuard {
+    static constexpr std::array signals{SIGSEGV, SIGBUS, SIGFPE, SIGILL, SIGABRT};
+
+    explicit CrashGuard(const std::filesystem::path &dir) : __dir{dir.native()} {
+      crash_dir.store(__dir.c_str());
+      if (__sanitizer_set_death_callback) {
+        __sanitizer_set_death_callback(write_crash);
+      }
+      struct sigaction action{};
+      action.sa_handler = crash_signal_handler;
+      sigemptyset(&action.sa_mask);
+      for (size_t i = 0; i < signals.size(); i += 1) {
+        ::sigaction(signals[i], nullptr, &__previous[i]);
+        __installed[i] = __previous[i].sa_handler == SIG_DFL &&
+          ::sigaction(signals[i], &action, nullptr) == 0;
+      }
+    }
+    CrashGuard(const CrashGuard &) = delete;
+    CrashGuard &operator=(const CrashGuard &) = delete;
+    ~CrashGuard() {
+      for (size_t i = 0; i < signals.size(); i += 1) {
+        if (__installed[i]) {
+          ::sigaction(signals[i], &__previous[i], nullptr);
+        }
+      }
+      if (__sanitizer_set_death_callback) {
+        __sanitizer_set_death_callback(nullptr);
+      }
+      crash_data.store(nullptr);
+      crash_dir.store(nullptr);
+    }
+
+  private:
+    std::string __dir;
+    std::array<struct sigaction, signals.size()> __previous{};
+    std::array<bool, signals.size()> __installed{};
+  };
+
+  /*
+    Mutates input with 1 to 4 stacked mutations in the style of libFuzzer : flipping a bit,
+    replacing, inserting or erasing bytes, copying a chunk within the input, writing an
+    interesting integer, adding a small delta to a byte and splicing in the tail of another
+    corpus input. The result has at most max_size bytes.
+  */
+  void mutate(
+    std::vector<std::byte> &input,
+    std::span<const std::vector<std::byte>> corpus,
+    size_t max_size,
+    const Generator &gen
+  ) {
+    constexpr std::array<uint64_t, 12> interesting{
+      0, 1, 16, 32, 64, 100, 127, 128, 255, 256, 1024, 0xffff'ffff'ffff'ffff
+    };
+    auto position = [&](size_t end) { return random_integer<size_t>(0, end, gen); };
+    size_t count = random_integer<size_t>(1, 4, gen);
+    for (size_t m = 0; m < count; m += 1) {
+      size_t size = input.size();
+      switch (size == 0 ? 2 : random_integer(0, 7, gen)) {
+        case 0:
+          input[position(size - 1)] ^= std::byte{1} << random_integer(0, 7, gen);
+          break;
+        case 1:
+          input[position(size - 1)] = static_cast<std::byte>(random_integer(0, 255, gen));
+          break;
+        case 2:
+          input.insert(
+            input.begin() + static_cast<ptrdiff_t>(position(size)),
+            random_integer<size_t>(1, 4, gen),
+            static_cast<std::byte>(random_integer(0, 255, gen))
+          );
+          break;
+        case 3: {
+          size_t beg = position(size - 1);
+          size_t len = random_integer<size_t>(1, std::min<size_t>(size - beg, 8), gen);
+          input.erase(
+            input.begin() + static_cast<ptrdiff_t>(beg),
+            input.begin() + static_cast<ptrdiff_t>(beg + len)
+          );
+          break;
+        }
+        case 4: {
+          size_t from = position(size - 1);
+          size_t to = position(size - 1);
+          size_t len = random_integer<size_t>(1, size - std::max(from, to), gen);
+          std::memmove(input.data() + to, input.data() + from, len);
+          break;
+        }
+        case 5: {
+          size_t width = size_t{1} << random_integer(0, 3, gen);
+          width = width > size ? 1 : width;
+          uint64_t value = interesting[random_integer<size_t>(0, interesting.size() - 1, gen)];
+          size_t beg = position(size - width);
+          for (size_t i = 0; i < width; i += 1) {
+            input[beg + i] = static_cast<std::byte>(value >> (8 * i));
+          }
+          break;
+        }
+        case 6: {
+          auto &b = input[position(size - 1)];
+          b = static_cast<std::byte>(static_cast<int>(b) + random_integer(-16, 16, gen));
+          break;
+        }
+        default: {
+          const auto &other = corpus[random_integer<size_t>(0, corpus.size() - 1, gen)];
+          if (!other.empty()) {
+            input.resize(position(size));
+            size_t tail = position(other.size() - 1);
+            input.insert(input.end(), other.begin() + static_cast<ptrdiff_t>(tail), other.end());
+          }
+          break;
+        }
+      }
+      if (input.size() > max_size) {
+        input.resize(max_size);
+      }
+    }
+  }
+
+  /*
+    Runs a fuzz target on one input, reseeding the generator of the calling thread like a test.
+    Failed expectations fail the input like a thrown assertion.
+  */
+  std::optional<ExceptionInfo> run_input(
+    FuzzTarget f, std::string_view name, std::span<const std::byte> data
+  ) {
+    auto seed = SeedScope{test_seed(name)};
+    auto expectations = ExpectScope{};
+    try {
+      f(data);
+    } catch (...) {
+      return translate_exception(std::current_exception());
+    }
+    return expectations.take();
+  }
+
+  /*
+    A fuzz target, declared by JOWI_ADD_FUZZ as a constinit variable. Running it as a test
+    replays its corpus, fuzz() runs a coverage guided mutation loop growing the corpus.
+  */
+  export struct FuzzEntry final : public GenericTestEntry {
+    constexpr FuzzEntry(
+      std::string_view name,
+      FuzzTarget f,
+      std::source_location loc = std::source_location::current()
+    ) : __name{name}, __f{f}, __loc{loc} {}
+
+    /*
+      Creates the entry of a default constructible fuzz target, named after its type.
+    */
+    template <std::default_initializable T>
+      requires(std::invocable<T &, std::span<const std::byte>>)
+    static constexpr FuzzEntry of(std::source_location loc = std::source_location::current()) {
+      return FuzzEntry{
+        get_type_name<T>(), [](std::span<const std::byte> data) { T{}(data); }, loc
+      };
+    }
+
+    std::string_view name() const override {
+      return __name;
+    }
+    const std::source_location &location() const {
+      return __loc;
+    }
+
+    /*
+      The corpus directory of the target.
+    */
+    std::filesystem::path corpus(const FuzzConfig &config = fuzz_config()) const {
+      return config.corpus / __name;
+    }
+
+    /*
+      Runs the empty input then every file of the corpus, throws a FailAssertion naming the first
+      failing input. Files are memory mapped and passed to the target without copying them.
+    */
+    void replay(const FuzzConfig &config = fuzz_config()) const {
+      if (auto err = run_input(__f, __name, {})) {
+        throw FailAssertion{
+          std::format("The empty input fails : {} : {}", err->name, err->message)
+        };
+      }
+      std::error_code ec;
+      for (const auto &file : std::filesystem::directory_iterator{corpus(config), ec}) {
+        if (!file.is_regular_file(ec)) {
+          continue;
+        }
+        auto mapped = MappedFile::open(file.path());
+        if (!mapped) {
+          throw std::runtime_error{std::format("cannot map '{}'", file.path().string())};
+        }
+        if (auto err = run_input(__f, __name, mapped->bytes())) {
+          throw FailAssertion{std::format(
+            "Input '{}' fails : {} : {}", file.path().string(), err->name, err->message
+          )};
+        }
+      }
+    }
+
+    TestResult run_test() const override {
+      return run_measured(
+        __name,
+        [](const void *entry) -> std::optional<ExceptionInfo> {
+          static_cast<const FuzzEntry *>(entry)->replay();
+          return std::nullopt;
+        },
+        this
+      );
+    }
+
+    /*
+      Mutates the inputs of the corpus until an input fails or config.runs inputs ran. Inputs
+      reaching new coverage are added to the corpus directory, a failing input is written next to
+      them as 'crash-<hash>', also when it kills the process. Without coverage instrumentation
+      the corpus does not grow and inputs are mutated blindly. progress is called whenever the
+      corpus grows.
+    */
+    FuzzReport fuzz(
+      const FuzzConfig &config = fuzz_config(),
+      std::function<void(const FuzzReport &)> progress = {}
+    ) const {
+      auto dir = corpus(config);
+      std::error_code ec;
+      std::filesystem::create_directories(dir, ec);
+      auto gen = Generator{test_seed(__name)};
+      auto coverage = CoverageMap{};
+      coverage.collect();
+      auto guard = CrashGuard{dir};
+      FuzzReport report;
+      // Inputs are run from an exactly sized copy, so that sanitizers catch reads past the end.
+      auto run = [&](std::span<const std::byte> input) {
+        auto copy = std::make_unique_for_overwrite<std::byte[]>(input.size());
+        std::copy(input.begin(), input.end(), copy.get());
+        crash_size.store(input.size());
+        crash_data.store(copy.get());
+        auto err = run_input(__f, __name, std::span{copy.get(), input.size()});
+        crash_data.store(nullptr);
+        report.runs += 1;
+        return err;
+      };
+      auto fail = [&](std::span<const std::byte> input, ExceptionInfo err) {
+        report.features = coverage.features();
+        report.failure = FuzzFailure{save_input(dir, "crash-", input), std::move(err)};
+        return report;
+      };
+
+      std::vector<std::vector<std::byte>> inputs;
+      for (const auto &file : std::filesystem::directory_iterator{dir, ec}) {
+        if (!file.is_regular_file(ec)) {
+          continue;
+        }
+        auto mapped = MappedFile::open(file.path());
+        if (!mapped) {
+          continue;
+        }
+        auto bytes = mapped->bytes();
+        if (auto err = run(bytes)) {
+          report.features = coverage.features();
+          report.failure = FuzzFailure{file.path(), std::move(err.value())};
+          return report;
+        }
+        coverage.collect();
+        inputs.emplace_back(bytes.begin(), bytes.end());
+      }
+      if (inputs.empty()) {
+        inputs.emplace_back();
+        if (auto err = run({})) {
+          return fail({}, std::move(err.value()));
+        }
+        coverage.collect();
+      }
+      report.corpus_size = inputs.size();
+      report.features = coverage.features();
+      if (progress) {
+        progress(report);
+      }
+
+      std::vector<std::byte> input;
+      while (config.runs == 0 || report.runs < config.runs) {
+        input = inputs[random_integer<size_t>(0, inputs.size() - 1, gen)];
+        mutate(input, inputs, config.max_size, gen);
+        if (auto err = run(input)) {
+          return fail(input, std::move(err.value()));
+        }
+        if (coverage.collect() != 0) {
+          save_input(dir, "", input);
+          inputs.push_back(input);
+          report.corpus_size = inputs.size();
+          report.features = coverage.features();
+          if (progress) {
+            progress(report);
+          }
+        }
+      }
+      report.features = coverage.features();
+      return report;
+    }
+
+  private:
+    std::string_view __name;
+    FuzzTarget __f;
+    std::source_location __loc;
+  };
+}
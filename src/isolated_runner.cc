@@ -0,0 +1,465 @@
+module;
+#include <sys/wait.h>
+#include <algorithm>
+#include <array>
+#include <cerrno>
+#include <chrono>
+#include <csignal>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <deque>
+#include <format>
+#include <optional>
+#include <poll.h>
+#include <signal.h>
+#include <span>
+#include <string>
+#include <string_view>
+#include <system_error>
+#include <unistd.h>
+#include <vector>
+export module jowi.test_lib:IsolatedRunner;
+import :alloc;
+import :exception;
+import :perf;
+import :resources;
+import :statistics;
+import :TestEntry;
+import :TestRunner;
+
+namespace jowi::test_lib {
+  bool write_all(int fd, const void *data, size_t n) {
+    auto ptr = static_cast<const char *>(data);
+    while (n != 0) {
+      ssize_t written = ::write(fd, ptr, n);
+      if (written < 0) {
+        if (errno == EINTR) {
+          continue;
+        }
+        return false;
+      }
+      ptr += written;
+      n -= static_cast<size_t>(written);
+    }
+    return true;
+  }
+
+  /*
+    Reads exactly n bytes. Returns false when the other end is closed before n bytes are read.
+  */
+  bool read_all(int fd, void *data, size_t n) {
+    auto ptr = static_cast<char *>(data);
+    while (n != 0) {
+      ssize_t got = ::read(fd, ptr, n);
+      if (got < 0 && errno == EINTR) {
+        continue;
+      }
+      if (got <= 0) {
+        return false;
+      }
+      ptr += got;
+      n -= static_cast<size_t>(got);
+    }
+    return true;
+  }
+
+  /*
+    Compact binary encoding of a TestResult, used to send results from a worker process back to
+    the parent. Both ends are the same executable, hence integers are written in native order.
+  */
+  struct ResultWriter {
+    std::string buf;
+
+    template <class T> ResultWriter &put(T v) {
+      buf.append(reinterpret_cast<const char *>(&v), sizeof(T));
+      return *this;
+    }
+    ResultWriter &put(std::string_view v) {
+      put(static_cast<uint32_t>(v.size()));
+      buf.append(v);
+      return *this;
+    }
+  };
+
+  struct ResultReader {
+    std::string_view buf;
+
+    template <class T> T get() {
+      T v{};
+      std::memcpy(&v, buf.data(), std::min(sizeof(T), buf.size()));
+      buf.remove_prefix(std::min(sizeof(T), buf.size()));
+      return v;
+    }
+    std::string get_string() {
+      size_t len = std::min<size_t>(get<uint32_t>(), buf.size());
+      auto v = std::string{buf.substr(0, len)};
+      buf.remove_prefix(len);
+      return v;
+    }
+  };
+
+  std::array<std::optional<double>, 5> perf_counter_values(const PerfCounters &c) {
+    return {c.cycles, c.instructions, c.branch_misses, c.l1d_read_misses, c.llc_misses};
+  }
+  std::array<std::optional<double> *, 5> perf_counter_values(PerfCounters &c) {
+    return {&c.cycles, &c.instructions, &c.branch_misses, &c.l1d_read_misses, &c.llc_misses};
+  }
+
+  std::string encode_result(const TestResult &res) {
+    ResultWriter w;
+    w.put(uint32_t{0});
+    w.put(static_cast<int64_t>(
+      std::chrono::duration_cast<std::chrono::nanoseconds>(res.running_time()).count()
+    ));
+    auto err = res.get_error();
+    w.put(static_cast<uint8_t>(err.has_value()));
+    if (err) {
+      w.put(std::string_view{err->name}).put(std::string_view{err->message});
+    }
+    const auto &bench = res.benchmark();
+    w.put(static_cast<uint8_t>(bench.has_value()));
+    if (bench) {
+      w.put(static_cast<uint64_t>(bench->iterations));
+      w.put(static_cast<uint32_t>(bench->samples.size()));
+      for (double sample : bench->samples) {
+        w.put(sample);
+      }
+    }
+    const auto &usage = res.resources();
+    w.put(static_cast<uint8_t>(usage.has_value()));
+    if (usage) {
+      w.put(static_cast<int64_t>(usage->user_time.count()))
+        .put(static_cast<int64_t>(usage->system_time.count()))
+        .put(usage->max_rss_delta_kb)
+        .put(usage->minor_faults)
+        .put(usage->major_faults)
+        .put(usage->voluntary_switches)
+        .put(usage->involuntary_switches);
+    }
+    const auto &counters = res.counters();
+    w.put(static_cast<uint8_t>(counters.has_value()));
+    if (counters) {
+      for (const auto &counter : perf_counter_values(counters.value())) {
+        w.put(static_cast<uint8_t>(counter.has_value())).put(counter.value_or(0));
+      }
+    }
+    w.put(static_cast<uint64_t>(res.arena_high_water_mark()));
+    const auto &allocs = res.allocations();
+    w.put(static_cast<uint8_t>(allocs.has_value()));
+    if (allocs) {
+      w.put(allocs->count).put(allocs->bytes).put(allocs->peak_live_bytes);
+    }
+    uint32_t len = static_cast<uint32_t>(w.buf.size() - sizeof(uint32_t));
+    std::memcpy(w.buf.data(), &len, sizeof(len));
+    return std::move(w.buf);
+  }
+
+  TestResult decode_result(std::string_view payload) {
+    ResultReader r{payload};
+    auto dur = std::chrono::duration_cast<std::chrono::system_clock::duration>(
+      std::chrono::nanoseconds{r.get<int64_t>()}
+    );
+    auto res = TestResult{dur};
+    if (r.get<uint8_t>() != 0) {
+      auto name = r.get_string();
+      auto message = r.get_string();
+      res = TestResult{dur, ExceptionInfo{std::move(name), std::move(message)}};
+    }
+    if (r.get<uint8_t>() != 0) {
+      size_t iterations = r.get<uint64_t>();
+      std::vector<double> samples(r.get<uint32_t>());
+      for (double &sample : samples) {
+        sample = r.get<double>();
+      }
+      res.set_benchmark(BenchmarkStats::from_samples(iterations, std::move(samples)));
+    }
+    if (r.get<uint8_t>() != 0) {
+      auto user_time = std::chrono::microseconds{r.get<int64_t>()};
+      auto system_time = std::chrono::microseconds{r.get<int64_t>()};
+      auto max_rss_delta_kb = r.get<int64_t>();
+      auto minor_faults = r.get<int64_t>();
+      auto major_faults = r.get<int64_t>();
+      auto voluntary_switches = r.get<int64_t>();
+      auto involuntary_switches = r.get<int64_t>();
+      res.set_resources(ResourceUsage{
+        user_time,
+        system_time,
+        max_rss_delta_kb,
+        minor_faults,
+        major_faults,
+        voluntary_switches,
+        involuntary_switches
+      });
+    }
+    if (r.get<uint8_t>() != 0) {
+      PerfCounters counters{};
+      for (auto *counter : perf_counter_values(counters)) {
+        bool has_value = r.get<uint8_t>() != 0;
+        double value = r.get<double>();
+        if (has_value) {
+          *counter = value;
+        }
+      }
+      res.set_counters(counters);
+    }
+    res.set_arena_high_water_mark(static_cast<size_t>(r.get<uint64_t>()));
+    if (r.get<uint8_t>() != 0) {
+      auto count = r.get<uint64_t>();
+      auto bytes = r.get<uint64_t>();
+      auto peak_live_bytes = r.get<uint64_t>();
+      res.set_allocations(AllocStats{count, bytes, peak_live_bytes});
+    }
+    return res;
+  }
+
+  std::optional<TestResult> read_result(int fd) {
+    uint32_t len = 0;
+    if (!read_all(fd, &len, sizeof(len))) {
+      return std::nullopt;
+    }
+    std::string payload(len, '\0');
+    if (!read_all(fd, payload.data(), len)) {
+      return std::nullopt;
+    }
+    return decode_result(payload);
+  }
+
+  std::string_view signal_name(int sig) {
+    switch (sig) {
+      case SIGSEGV:
+        return "SIGSEGV";
+      case SIGABRT:
+        return "SIGABRT";
+      case SIGBUS:
+        return "SIGBUS";
+      case SIGFPE:
+        return "SIGFPE";
+      case SIGILL:
+        return "SIGILL";
+      case SIGKILL:
+        return "SIGKILL";
+      case SIGTERM:
+        return "SIGTERM";
+      case SIGTRAP:
+        return "SIGTRAP";
+      case SIGPIPE:
+        return "SIGPIPE";
+      default:
+        return "SIGNAL";
+    }
+  }
+
+  /*
+    Describes how a worker process died while running a test.
+  */
+  ExceptionInfo crash_info(int status) {
+    if (WIFSIGNALED(status)) {
+      int sig = WTERMSIG(status);
+      return ExceptionInfo{
+        std::string{signal_name(sig)},
+        std::format("Test process was terminated by signal {} ({})", sig, ::strsignal(sig))
+      };
+    }
+    if (WIFEXITED(status)) {
+      return ExceptionInfo{
+        "exit", std::format("Test process exited with code {}", WEXITSTATUS(status))
+      };
+    }
+    return ExceptionInfo{"crash", "Test process terminated abnormally"};
+  }
+
+  struct WorkerProcess {
+    pid_t pid = -1;
+    int req_fd = -1;
+    int res_fd = -1;
+    std::optional<size_t> slot = std::nullopt;
+    std::chrono::steady_clock::time_point started = {};
+  };
+
+  /*
+    The loop run by a forked worker. Slot indices are read from req_fd until the parent closes it,
+    results are written back to res_fd.
+  */
+  [[noreturn]] void worker_main(
+    std::span<const GenericTestEntry *const> entries, int req_fd, int res_fd
+  ) {
+    uint64_t slot = 0;
+    while (read_all(req_fd, &slot, sizeof(slot))) {
+      auto frame = encode_result(entries[slot]->run_test());
+      if (!write_all(res_fd, frame.data(), frame.size())) {
+        break;
+      }
+    }
+    std::fflush(stdout);
+    std::fflush(stderr);
+    ::_exit(0);
+  }
+
+  /*
+    Runs tests in a pool of pre-forked worker processes. A worker is kept alive across tests and
+    is only respawned when it dies, in which case the test it was running is reported as failed
+    with the signal or exit code of the worker.
+  */
+  export struct IsolatedRunner {
+    IsolatedRunner(size_t jobs, bool fail_fast = false) :
+      __jobs{std::max<size_t>(jobs, 1)}, __fail_fast{fail_fast} {}
+
+    /*
+      Same contract as TestRunner::run, check is called from the calling thread. With fail fast,
+      workers still running a test when the first failure arrives are killed and their tests are
+      not delivered.
+    */
+    void run(
+      std::span<const GenericTestEntry *const> entries,
+      const TestRunner::sink_type &sink,
+      std::span<const size_t> order = {},
+      const TestRunner::start_type &started = {},
+      const TestRunner::check_type &check = {}
+    ) const {
+      if (entries.empty()) {
+        return;
+      }
+      auto prev_handler = std::signal(SIGPIPE, SIG_IGN);
+      auto slots = schedule_order(entries.size(), order);
+      auto pending = std::deque<size_t>{slots.begin(), slots.end()};
+      OrderedSink ordered{entries.size(), sink};
+      std::vector<WorkerProcess> workers(std::min(__jobs, entries.size()));
+      auto dispatch = [&](WorkerProcess &w) {
+        if (pending.empty()) {
+          return;
+        }
+        uint64_t slot = pending.front();
+        pending.pop_front();
+        w.slot = slot;
+        w.started = std::chrono::steady_clock::now();
+        if (started) {
+          started(slot);
+        }
+        // A failed write means the worker is dead, which is picked up by poll.
+        write_all(w.req_fd, &slot, sizeof(slot));
+      };
+      for (auto &w : workers) {
+        spawn(w, workers, entries);
+        dispatch(w);
+      }
+
+      std::vector<pollfd> fds;
+      std::vector<size_t> owners;
+      while (std::ranges::any_of(workers, [](const auto &w) { return w.slot.has_value(); })) {
+        fds.clear();
+        owners.clear();
+        for (size_t id = 0; id < workers.size(); id += 1) {
+          if (workers[id].slot) {
+            fds.push_back(pollfd{workers[id].res_fd, POLLIN, 0});
+            owners.push_back(id);
+          }
+        }
+        if (::poll(fds.data(), fds.size(), -1) < 0) {
+          if (errno == EINTR) {
+            continue;
+          }
+          throw std::system_error{errno, std::generic_category(), "poll"};
+        }
+        bool cancel = false;
+        for (size_t k = 0; k < fds.size(); k += 1) {
+          if (fds[k].revents == 0) {
+            continue;
+          }
+          auto &w = workers[owners[k]];
+          size_t slot = w.slot.value();
+          w.slot.reset();
+          auto res = read_result(w.res_fd);
+          if (!res) {
+            auto dur = std::chrono::duration_cast<std::chrono::system_clock::duration>(
+              std::chrono::steady_clock::now() - w.started
+            );
+            res.emplace(dur, crash_info(reap(w)));
+            if (!pending.empty()) {
+              spawn(w, workers, entries);
+            }
+          }
+          if (check) {
+            check(slot, res.value());
+          }
+          cancel = cancel || (__fail_fast && res->is_error());
+          ordered.deliver(slot, std::move(res.value()));
+          dispatch(w);
+        }
+        if (cancel) {
+          pending.clear();
+          for (auto &w : workers) {
+            if (w.slot) {
+              ::kill(w.pid, SIGKILL);
+              reap(w);
+            }
+          }
+        }
+      }
+      for (auto &w : workers) {
+        if (w.pid != -1) {
+          reap(w);
+        }
+      }
+      ordered.finish();
+      std::signal(SIGPIPE, prev_handler);
+    }
+
+  private:
+    size_t __jobs;
+    bool __fail_fast;
+
+    static void spawn(
+      WorkerProcess &w,
+      std::span<const WorkerProcess> workers,
+      std::span<const GenericTestEntry *const> entries
+    ) {
+      int req[2];
+      int res[2];
+      if (::pipe(req) != 0) {
+        throw std::system_error{errno, std::generic_category(), "pipe"};
+      }
+      if (::pipe(res) != 0) {
+        ::close(req[0]);
+        ::close(req[1]);
+        throw std::system_error{errno, std::generic_category(), "pipe"};
+      }
+      std::fflush(stdout);
+      std::fflush(stderr);
+      pid_t pid = ::fork();
+      if (pid < 0) {
+        throw std::system_error{errno, std::generic_category(), "fork"};
+      }
+      if (pid == 0) {
+        ::close(req[1]);
+        ::close(res[0]);
+        // Holding the pipes of the other workers would keep them from seeing the end of input.
+        for (const auto &other : workers) {
+          if (other.pid != -1 && &other != &w) {
+            ::close(other.req_fd);
+            ::close(other.res_fd);
+          }
+        }
+        worker_main(entries, req[0], res[1]);
+      }
+      ::close(req[0]);
+      ::close(res[1]);
+      w.pid = pid;
+      w.req_fd = req[1];
+      w.res_fd = res[0];
+    }
+
+    /*
+      Closes the pipes of a worker and waits for it to exit, returning its wait status.
+    */
+    static int reap(WorkerProcess &w) {
+      ::close(w.req_fd);
+      ::close(w.res_fd);
+      int status = 0;
+      while (::waitpid(w.pid, &status, 0) < 0 && errno == EINTR) {
+      }
+      w = WorkerProcess{};
+      return status;
+    }
+  };
+}
@@ -1,9 +1,16 @@
 #include <algorithm>
+#include <charconv>
+#include <chrono>
+#include <cstdint>
+#include <cstdlib>
 #include <expected>
+#include <filesystem>
 #include <format>
+#include <memory>
 #include <optional>
 #include <print>
 #include <string>
+#include <vector>
 import jowi.test_lib;
 import jowi.cli;
 import jowi.tui;
@@ -32,17 +39,45 @@ struct FilterExcludeValidator {
   }
 };
 
-struct ValidTestNameValidator {
+/*
+  Test names have to exist, globs and regular expressions have to compile.
+*/
+struct TestPatternValidator {
   std::reference_wrapper<const test_lib::TestSuite> tests;
 
   std::expected<void, cli::ParseError> validate(std::optional<std::string_view> v) const {
     if (!v) {
       return std::unexpected{cli::ParseError{cli::ParseErrorType::NO_VALUE_GIVEN, ""}};
     }
-    if (!tests.get().get(v.value())) {
+    if (test_lib::TestFilter::is_name(v.value())) {
+      if (!tests.get().find(v.value())) {
+        return std::unexpected{cli::ParseError{
+          cli::ParseErrorType::INVALID_VALUE,
+          "'{}' is not a valid test name. Use --list for the full list of tests",
+          v.value()
+        }};
+      }
+    } else if (auto res = test_lib::TestFilter{}.add(v.value()); !res) {
+      return std::unexpected{
+        cli::ParseError{cli::ParseErrorType::INVALID_VALUE, "{}", res.error()}
+      };
+    }
+    return {};
+  }
+};
+
+struct FuzzTargetValidator {
+  std::reference_wrapper<const test_lib::TestSuite> tests;
+
+  std::expected<void, cli::ParseError> validate(std::optional<std::string_view> v) const {
+    if (!v) {
+      return std::unexpected{cli::ParseError{cli::ParseErrorType::NO_VALUE_GIVEN, ""}};
+    }
+    auto test = tests.get().get(v.value());
+    if (!test || !dynamic_cast<const test_lib::FuzzEntry *>(&test->get())) {
       return std::unexpected{cli::ParseError{
         cli::ParseErrorType::INVALID_VALUE,
-        "'{}' is not a valid test name. Use --list for the full list of tests",
+        "'{}' is not a fuzz target. Use --list for the full list of tests",
         v.value()
       }};
     }
@@ -50,12 +85,227 @@ struct ValidTestNameValidator {
   }
 };
 
+struct ReporterValidator {
+  std::expected<void, cli::ParseError> validate(std::optional<std::string_view> v) const {
+    if (!v) {
+      return std::unexpected{cli::ParseError{cli::ParseErrorType::NO_VALUE_GIVEN, ""}};
+    }
+    if (v != "console" && v != "jsonl" && v != "junit") {
+      return std::unexpected{cli::ParseError{
+        cli::ParseErrorType::INVALID_VALUE,
+        "'{}' is not a valid reporter, expected one of console, jsonl or junit",
+        v.value()
+      }};
+    }
+    return {};
+  }
+};
+
+struct OutputValidator {
+  std::expected<void, cli::ParseError> post_validate(
+    std::optional<std::reference_wrapper<const cli::ArgKey>> k, cli::ParsedArg &args
+  ) const {
+    if (!args.contains("--output")) {
+      return {};
+    }
+    for (std::string_view v : args.filter("--reporter")) {
+      if (v != "console") {
+        return {};
+      }
+    }
+    return std::unexpected{cli::ParseError{
+      cli::ParseErrorType::INVALID_VALUE, "'--output' requires '--reporter jsonl' or 'junit'"
+    }};
+  }
+};
+
+struct PositiveIntegerValidator {
+  std::expected<void, cli::ParseError> validate(std::optional<std::string_view> v) const {
+    if (!v) {
+      return std::unexpected{cli::ParseError{cli::ParseErrorType::NO_VALUE_GIVEN, ""}};
+    }
+    size_t value = 0;
+    auto [ptr, ec] = std::from_chars(v->data(), v->data() + v->size(), value);
+    if (ec != std::errc{} || ptr != v->data() + v->size() || value == 0) {
+      return std::unexpected{cli::ParseError{
+        cli::ParseErrorType::INVALID_VALUE, "'{}' is not a positive integer", v.value()
+      }};
+    }
+    return {};
+  }
+};
+
+struct PercentageValidator {
+  std::expected<void, cli::ParseError> validate(std::optional<std::string_view> v) const {
+    if (!v) {
+      return std::unexpected{cli::ParseError{cli::ParseErrorType::NO_VALUE_GIVEN, ""}};
+    }
+    auto value = std::string{v.value()};
+    char *end = nullptr;
+    double pct = std::strtod(value.c_str(), &end);
+    if (value.empty() || end != value.c_str() + value.size() || !(pct >= 0)) {
+      return std::unexpected{cli::ParseError{
+        cli::ParseErrorType::INVALID_VALUE, "'{}' is not a non negative percentage", v.value()
+      }};
+    }
+    return {};
+  }
+};
+
+struct SeedValidator {
+  std::expected<void, cli::ParseError> validate(std::optional<std::string_view> v) const {
+    if (!v) {
+      return std::unexpected{cli::ParseError{cli::ParseErrorType::NO_VALUE_GIVEN, ""}};
+    }
+    uint64_t value = 0;
+    auto [ptr, ec] = std::from_chars(v->data(), v->data() + v->size(), value);
+    if (ec != std::errc{} || ptr != v->data() + v->size()) {
+      return std::unexpected{cli::ParseError{
+        cli::ParseErrorType::INVALID_VALUE, "'{}' is not an unsigned 64 bit integer", v.value()
+      }};
+    }
+    return {};
+  }
+};
+
+struct ShardValidator {
+  std::expected<void, cli::ParseError> validate(std::optional<std::string_view> v) const {
+    if (!v) {
+      return std::unexpected{cli::ParseError{cli::ParseErrorType::NO_VALUE_GIVEN, ""}};
+    }
+    if (!test_lib::TestShard::parse(v.value())) {
+      return std::unexpected{cli::ParseError{
+        cli::ParseErrorType::INVALID_VALUE,
+        "'{}' is not a valid shard, expected INDEX/COUNT with 0 <= INDEX < COUNT",
+        v.value()
+      }};
+    }
+    return {};
+  }
+};
+
+/*
+  Returns the first value given to an argument.
+*/
+std::optional<std::string_view> arg_value(cli::App &app, std::string_view key) {
+  for (std::string_view v : app.args().filter(key)) {
+    return v;
+  }
+  return std::nullopt;
+}
+
+size_t job_count(cli::App &app, const test_lib::TestContext &ctx) {
+  if (auto v = arg_value(app, "--jobs")) {
+    size_t jobs = 1;
+    std::from_chars(v->data(), v->data() + v->size(), jobs);
+    return jobs;
+  }
+  return static_cast<size_t>(std::max(ctx.thread_count, 1));
+}
+
+std::string format_nanoseconds(double ns) {
+  if (ns < 1e3) {
+    return std::format("{:.2f} ns", ns);
+  } else if (ns < 1e6) {
+    return std::format("{:.2f} μs", ns / 1e3);
+  } else if (ns < 1e9) {
+    return std::format("{:.2f} ms", ns / 1e6);
+  }
+  return std::format("{:.2f} s", ns / 1e9);
+}
+
+void print_benchmark_output(const test_lib::BenchmarkStats &stats) {
+  std::print(
+    "{}",
+    tui::Layout{}
+      .style(tui::DomStyle{}.fg(tui::RgbColor::bright_cyan()))
+      .append_child(tui::Paragraph{
+        "      min {} median {} mean {} mad {} ({} samples x {} iterations)",
+        format_nanoseconds(stats.min),
+        format_nanoseconds(stats.median),
+        format_nanoseconds(stats.mean),
+        format_nanoseconds(stats.mad),
+        stats.samples.size(),
+        stats.iterations
+      })
+  );
+}
+
+void print_resource_output(const test_lib::ResourceUsage &usage) {
+  std::print(
+    "{}",
+    tui::Layout{}
+      .style(tui::DomStyle{}.fg(tui::RgbColor::bright_cyan()))
+      .append_child(tui::Paragraph{
+        "      cpu user {} sys {} | max rss {:+} KiB | faults {} minor {} major | "
+        "switches {} voluntary {} involuntary",
+        format_nanoseconds(static_cast<double>(usage.user_time.count()) * 1e3),
+        format_nanoseconds(static_cast<double>(usage.system_time.count()) * 1e3),
+        usage.max_rss_delta_kb,
+        usage.minor_faults,
+        usage.major_faults,
+        usage.voluntary_switches,
+        usage.involuntary_switches
+      })
+  );
+}
+
+std::string format_counter(std::optional<double> v) {
+  if (!v) {
+    return "n/a";
+  } else if (v.value() >= 1000) {
+    return std::format("{:.0f}", v.value());
+  }
+  return std::format("{:.2f}", v.value());
+}
+
+void print_counter_output(const test_lib::PerfCounters &counters) {
+  std::print(
+    "{}",
+    tui::Layout{}
+      .style(tui::DomStyle{}.fg(tui::RgbColor::bright_cyan()))
+      .append_child(tui::Paragraph{
+        "      cycles {} instructions {} ipc {} | branch misses {} | l1d read misses {} llc "
+        "misses {}",
+        format_counter(counters.cycles),
+        format_counter(counters.instructions),
+        format_counter(counters.ipc()),
+        format_counter(counters.branch_misses),
+        format_counter(counters.l1d_read_misses),
+        format_counter(counters.llc_misses)
+      })
+  );
+}
+
+void print_alloc_output(const test_lib::AllocStats &stats) {
+  std::print(
+    "{}",
+    tui::Layout{}
+      .style(tui::DomStyle{}.fg(tui::RgbColor::bright_cyan()))
+      .append_child(tui::Paragraph{
+        "      allocations {} ({} bytes, peak {} live bytes)",
+        stats.count,
+        stats.bytes,
+        stats.peak_live_bytes
+      })
+  );
+}
+
+void print_arena_output(size_t bytes) {
+  std::print(
+    "{}",
+    tui::Layout{}
+      .style(tui::DomStyle{}.fg(tui::RgbColor::bright_cyan()))
+      .append_child(tui::Paragraph{"      arena high water mark {} bytes", bytes})
+  );
+}
+
 void print_test_output(
   cli::App &app,
   std::string_view name,
   size_t i,
-  test_lib::TestResult &res,
-  test_lib::TestContext &ctx
+  const test_lib::TestResult &res,
+  const test_lib::TestContext &ctx
 ) {
   if (res.is_ok()) {
     std::print(
@@ -110,16 +360,213 @@ void print_test_output(
         )
     );
   }
+  if (res.benchmark()) {
+    print_benchmark_output(res.benchmark().value());
+  }
+  if (res.resources() && app.args().contains("--resources")) {
+    print_resource_output(res.resources().value());
+  }
+  if (res.counters()) {
+    print_counter_output(res.counters().value());
+  }
+  if (res.allocations()) {
+    print_alloc_output(res.allocations().value());
+  }
+  if (res.arena_high_water_mark() != 0) {
+    print_arena_output(res.arena_high_water_mark());
+  }
 }
 
-bool should_run_test(std::string_view name, cli::App &app) {
-  if (app.args().contains("--filter")) {
-    auto ic = app.args().filter("--filter");
-    return std::ranges::find(ic, name) != ic.end();
-  } else {
-    auto ex = app.args().filter("--exclude");
-    return std::ranges::find(ex, name) == ex.end();
+void print_skipped_output(std::string_view name, size_t i) {
+  std::print(
+    "{}",
+    tui::Layout{}
+      .append_child(
+        tui::Layout{}
+          .style(tui::DomStyle{}.fg(tui::RgbColor::bright_blue()))
+          .append_child(tui::Paragraph{"[{:3}]", i}.no_newline())
+      )
+      .append_child(
+        tui::Layout{}
+          .style(tui::DomStyle{}.fg(tui::RgbColor::bright_yellow()))
+          .append_child(tui::Paragraph{"[{:4}]", "OK!"}.no_newline())
+      )
+      .append_child(tui::Paragraph{"{}", name})
+  );
+}
+
+void print_fuzz_progress(const test_lib::FuzzReport &report) {
+  std::print(
+    "{}",
+    tui::Layout{}
+      .style(tui::DomStyle{}.fg(tui::RgbColor::bright_cyan()))
+      .append_child(tui::Paragraph{
+        "#{} corpus {} inputs | coverage {} features",
+        report.runs,
+        report.corpus_size,
+        report.features
+      })
+  );
+}
+
+/*
+  Fuzzes a single target until an input fails or --fuzz-runs inputs ran, returns the exit code.
+*/
+int run_fuzzer(const test_lib::FuzzEntry &entry) {
+  auto report = entry.fuzz(test_lib::fuzz_config(), print_fuzz_progress);
+  print_fuzz_progress(report);
+  if (!report.failure) {
+    return 0;
+  }
+  std::print(
+    "{}",
+    tui::Layout{}
+      .append_child(
+        tui::Layout{}
+          .style(tui::DomStyle{}.fg(tui::RgbColor::bright_red()))
+          .append_child(tui::Paragraph{"{}", report.failure->error.name})
+      )
+      .append_child(tui::Paragraph{"{}", report.failure->error.message})
+      .append_child(
+        tui::Layout{}
+          .style(tui::DomStyle{}.fg(tui::RgbColor::bright_yellow()))
+          .append_child(tui::Paragraph{
+            "Failing input written to '{}', it is replayed with the corpus of {}",
+            report.failure->input.string(),
+            entry.name()
+          })
+      )
+  );
+  return 1;
+}
+
+/*
+  The default reporter, prints colored results to the terminal. In quiet mode only failing tests
+  and the summary are printed.
+*/
+struct ConsoleReporter : public test_lib::TestListener {
+  ConsoleReporter(cli::App &app, const test_lib::TestContext &ctx, bool quiet) :
+    __app{app}, __ctx{ctx}, __quiet{quiet} {}
+
+  void run_started(size_t test_count) override {
+    std::print(
+      "{}",
+      tui::Layout{}
+        .style(tui::DomStyle{}.fg(tui::RgbColor::bright_cyan()))
+        .append_child(tui::Paragraph{"{:=<80}", ""})
+    );
+  }
+
+  void test_finished(size_t index, std::string_view name, const test_lib::TestResult &res)
+    override {
+    if (!__quiet || res.is_error()) {
+      print_test_output(__app, name, index, res, __ctx);
+    }
+  }
+
+  void test_skipped(size_t index, std::string_view name) override {
+    if (!__quiet) {
+      print_skipped_output(name, index);
+    }
+  }
+
+  void run_finished(const test_lib::RunSummary &summary) override {
+    std::print(
+      "{}",
+      tui::DomNode::vstack(
+        tui::Layout{}
+          .append_child(
+            tui::Layout{}
+              .style(tui::DomStyle{}.fg(tui::RgbColor::bright_cyan()))
+              .append_child(tui::Paragraph{"{:=<80}", ""})
+          )
+          .append_child(tui::Paragraph{
+            "Ran {:3} tests (shard {}/{})",
+            summary.passed + summary.failed,
+            summary.shard ? summary.shard->index : 0,
+            summary.shard ? summary.shard->count : 1
+          })
+          .append_child(
+            tui::Layout{}
+              .append_child(
+                tui::Layout{}
+                  .style(tui::DomStyle{}.fg(tui::RgbColor::bright_green()))
+                  .append_child(tui::Paragraph{"[{:4}]", "OK!"}.no_newline())
+              )
+              .append_child(tui::Paragraph{" {:3} tests", summary.passed})
+          )
+          .append_child(
+            tui::Layout{}
+              .append_child(
+                tui::Layout{}
+                  .style(tui::DomStyle{}.fg(tui::RgbColor::bright_red()))
+                  .append_child(tui::Paragraph{"[{:4}]", "ERR!"}.no_newline())
+              )
+              .append_child(tui::Paragraph{" {:3} tests", summary.failed})
+          )
+          .append_child(
+            tui::Layout{}
+              .append_child(
+                tui::Layout{}
+                  .style(tui::DomStyle{}.fg(tui::RgbColor::bright_yellow()))
+                  .append_child(tui::Paragraph{"[{:4}]", "EXC!"}.no_newline())
+              )
+              .append_child(tui::Paragraph{" {:3} tests", summary.skipped})
+          )
+      )
+    );
+    if (summary.failed != 0) {
+      std::print(
+        "{}",
+        tui::Layout{}
+          .style(tui::DomStyle{}.fg(tui::RgbColor::bright_yellow()))
+          .append_child(tui::Paragraph{
+            "Random seed {}, rerun with --seed {} to reproduce", summary.seed, summary.seed
+          })
+      );
+    }
   }
+
+private:
+  cli::App &__app;
+  const test_lib::TestContext &__ctx;
+  bool __quiet;
+};
+
+/*
+  Creates the reporter selected by --reporter, writing into --output or stdout.
+*/
+std::expected<std::unique_ptr<test_lib::TestListener>, std::string> make_reporter(
+  cli::App &app, const test_lib::TestContext &ctx, std::string_view exe
+) {
+  auto kind = arg_value(app, "--reporter").value_or("console");
+  if (kind == "console") {
+    return std::make_unique<ConsoleReporter>(app, ctx, app.args().contains("--quiet"));
+  }
+  auto output = arg_value(app, "--output");
+  auto writer = output ? test_lib::BufferedWriter::open(output.value())
+                       : test_lib::BufferedWriter::standard_output();
+  if (!writer) {
+    return std::unexpected{std::format("cannot open '{}' for writing", output.value())};
+  }
+  if (kind == "jsonl") {
+    return std::make_unique<test_lib::JsonLinesReporter>(std::move(writer.value()));
+  }
+  return std::make_unique<test_lib::JUnitReporter>(
+    std::move(writer.value()), std::filesystem::path{exe}.filename().string()
+  );
+}
+
+/*
+  Returns the ids of the tests selected by --filter or --exclude, in suite order.
+*/
+std::vector<size_t> select_tests(cli::App &app, const test_lib::TestSuite &tests) {
+  bool include = app.args().contains("--filter");
+  auto filter = test_lib::TestFilter{};
+  for (std::string_view pattern : app.args().filter(include ? "--filter" : "--exclude")) {
+    filter.add(pattern);
+  }
+  return filter.select(tests, include);
 }
 
 int main(int argc, const char **argv) {
@@ -129,17 +576,119 @@ int main(int argc, const char **argv) {
     Arguments
   */
   app.add_argument("--filter")
-    .help("A list of tests to run. This argument can be given multiple times")
+    .help(
+      "Tests to run, given as names, globs such as 'Suite.*' or regexes prefixed with 're:'. "
+      "This argument can be given multiple times"
+    )
     .require_value()
     .n_at_least(0)
     .add_validator(FilterExcludeValidator{})
-    .add_validator(ValidTestNameValidator{ctx.tests});
+    .add_validator(TestPatternValidator{ctx.tests});
   app.add_argument("--exclude")
-    .help("A list of tests to exclude. This argument can be given multiple times")
+    .help(
+      "Tests to exclude, accepts the same patterns as --filter. This argument can be given "
+      "multiple times"
+    )
     .require_value()
     .n_at_least(0)
     .add_validator(FilterExcludeValidator{})
-    .add_validator(ValidTestNameValidator{ctx.tests});
+    .add_validator(TestPatternValidator{ctx.tests});
+  app.add_argument("--jobs")
+    .help("The amount of threads used to run tests. Defaults to the thread count of the context")
+    .require_value()
+    .optional()
+    .add_validator(PositiveIntegerValidator{});
+  app.add_argument("--isolate")
+    .help("Runs tests in worker processes, a crashing test is reported as a failure")
+    .as_flag()
+    .optional();
+  app.add_argument("--shard")
+    .help("Runs only the tests in shard INDEX/COUNT, INDEX is zero based")
+    .require_value()
+    .optional()
+    .add_validator(ShardValidator{});
+  app.add_argument("--seed")
+    .help(
+      "Seeds the random generators, every test is seeded from this seed and its name. Defaults "
+      "to a random seed, printed when tests fail"
+    )
+    .require_value()
+    .optional()
+    .add_validator(SeedValidator{});
+  app.add_argument("--property-cases")
+    .help("The amount of cases generated for every property, defaults to 100")
+    .require_value()
+    .optional()
+    .add_validator(PositiveIntegerValidator{});
+  app.add_argument("--max-expect-failures")
+    .help("The most failed expectations listed per test, defaults to 32")
+    .require_value()
+    .optional()
+    .add_validator(PositiveIntegerValidator{});
+  app.add_argument("--corpus")
+    .help(
+      "The directory holding one corpus directory per fuzz target, replayed when the targets run "
+      "as tests. Defaults to '<executable>.corpus'"
+    )
+    .require_value()
+    .optional();
+  app.add_argument("--fuzz")
+    .help("Fuzzes a target, growing its corpus, until an input fails or --fuzz-runs inputs ran")
+    .require_value()
+    .optional()
+    .add_validator(FuzzTargetValidator{ctx.tests});
+  app.add_argument("--fuzz-runs")
+    .help("The amount of inputs tried by --fuzz, defaults to running until an input fails")
+    .require_value()
+    .optional()
+    .add_validator(PositiveIntegerValidator{});
+  app.add_argument("--durations")
+    .help(
+      "The per test duration history, used to start long tests first. Shards are balanced on it "
+      "only when it is given, every shard has to read the same file. Defaults to "
+      "'<executable>.durations'"
+    )
+    .require_value()
+    .optional();
+  app.add_argument("--fail-fast")
+    .help("Stops running tests after the first failure")
+    .as_flag()
+    .optional();
+  app.add_argument("--save-baseline")
+    .help("Saves the timing distribution of every benchmark that ran into a baseline file")
+    .require_value()
+    .optional();
+  app.add_argument("--compare-baseline")
+    .help("Fails benchmarks that got significantly slower than in a baseline file")
+    .require_value()
+    .optional();
+  app.add_argument("--regression-threshold")
+    .help("The slowdown in percent tolerated by --compare-baseline, defaults to 5")
+    .require_value()
+    .optional()
+    .add_validator(PercentageValidator{});
+  app.add_argument("--resources")
+    .help("Prints the cpu time, peak memory, page faults and context switches of every test")
+    .as_flag()
+    .optional();
+  app.add_argument("--counters")
+    .help("Counts cycles, instructions, branch and cache misses of every test with perf events")
+    .as_flag()
+    .optional();
+  app.add_argument("--reporter")
+    .help("The report format, one of 'console' (default), 'jsonl' or 'junit'")
+    .require_value()
+    .optional()
+    .add_validator(ReporterValidator{});
+  app.add_argument("--output")
+    .help("Writes the jsonl or junit report into a file instead of stdout")
+    .require_value()
+    .optional()
+    .add_validator(OutputValidator{});
+  app.add_argument("--quiet")
+    .help("Only prints failing tests and the summary on the console")
+    .as_flag()
+    .optional();
   app.add_argument("--list")
     .help("Lists all the available tests, this will ignore all previous arguments")
     .as_flag()
@@ -168,92 +717,177 @@ int main(int argc, const char **argv) {
     return 0;
   }
 
-  std::print(
-    "{}",
-    tui::Layout{}
-      .style(tui::DomStyle{}.fg(tui::RgbColor::bright_cyan()))
-      .append_child(tui::Paragraph{"{:=<80}", ""})
-  );
+  auto reporter = make_reporter(app, ctx, argv[0]);
+  if (!reporter) {
+    std::print(
+      stderr,
+      "{}",
+      tui::Layout{}
+        .style(tui::DomStyle{}.fg(tui::RgbColor::bright_red()))
+        .append_child(tui::Paragraph{"{}", reporter.error()})
+    );
+    return 1;
+  }
+  if (auto v = arg_value(app, "--seed")) {
+    uint64_t seed = 0;
+    std::from_chars(v->data(), v->data() + v->size(), seed);
+    test_lib::set_random_seed(seed);
+  }
+  if (auto v = arg_value(app, "--property-cases")) {
+    std::from_chars(v->data(), v->data() + v->size(), test_lib::property_config().cases);
+  }
+  if (auto v = arg_value(app, "--max-expect-failures")) {
+    std::from_chars(v->data(), v->data() + v->size(), test_lib::expect_config().max_failures);
+  }
+  auto &fuzz_config = test_lib::fuzz_config();
+  fuzz_config.corpus = arg_value(app, "--corpus")
+                         .transform([](auto v) { return std::filesystem::path{v}; })
+                         .value_or(std::filesystem::path{argv[0]}.concat(".corpus"));
+  if (auto v = arg_value(app, "--fuzz-runs")) {
+    std::from_chars(v->data(), v->data() + v->size(), fuzz_config.runs);
+  }
   /*
     Run tests based on --filter and --exclude. When both are given --filter will be applied.
   */
   ctx.setup(argc, argv);
+  if (auto name = arg_value(app, "--fuzz")) {
+    int code = run_fuzzer(
+      dynamic_cast<const test_lib::FuzzEntry &>(ctx.tests.get(name.value()).value().get())
+    );
+    ctx.tear_down();
+    return code;
+  }
+  if (app.args().contains("--counters")) {
+    test_lib::enable_perf_counters();
+  }
+  /*
+    Run every tests. Tests are run in parallel, but results are printed in the order of the suite.
+  */
+  auto ids = select_tests(app, ctx.tests);
+  std::vector<std::string_view> names;
+  for (size_t test_id : ids) {
+    names.push_back(ctx.tests.get(test_id).value().get().name());
+  }
+  auto shared_durations = arg_value(app, "--durations");
+  auto durations_path = shared_durations
+                          .transform([](auto v) { return std::filesystem::path{v}; })
+                          .value_or(std::filesystem::path{argv[0]}.concat(".durations"));
+  auto durations = test_lib::DurationStore::load(durations_path);
+  auto shard = arg_value(app, "--shard").and_then(test_lib::TestShard::parse);
+  if (shard) {
+    /*
+      Shards only balance on durations given explicitly, every shard has to read the same history
+      to compute the same partition. The history next to the executable differs between machines
+      and shards, it only orders the tests of this shard.
+    */
+    std::vector<size_t> shard_ids;
+    auto partition = shared_durations ? shard->select(names, durations) : shard->select(names);
+    for (size_t pos : partition) {
+      shard_ids.push_back(ids[pos]);
+    }
+    ids = std::move(shard_ids);
+  }
+  std::vector<const test_lib::GenericTestEntry *> entries;
+  names.clear();
+  for (size_t test_id : ids) {
+    entries.push_back(&ctx.tests.get(test_id).value().get());
+    names.push_back(entries.back()->name());
+  }
+  auto order = durations.longest_first(names);
   /*
-    Run every tests
+    Results are reported through the event bus, test threads never wait on the reporters.
   */
+  auto listeners = ctx.listeners();
+  listeners.insert(listeners.begin(), reporter.value().get());
+  auto bus = test_lib::EventBus{listeners};
   uint64_t i = 0;
   uint64_t succ_count = 0;
   uint64_t err_count = 0;
-  for (const auto &test : ctx.tests) {
-    if (should_run_test(test->name(), app)) {
-      auto res = test->run_test();
-      if (res.is_ok()) {
-        succ_count += 1;
-      } else {
-        err_count += 1;
-      }
-      print_test_output(app, test.get()->name(), i, res, ctx);
+  auto print_skipped_until = [&](uint64_t end) {
+    for (; i < end; i += 1) {
+      bus.test_skipped(i, ctx.tests.get(i).value().get().name());
+    }
+  };
+  bus.run_started(entries.size());
+  auto run_beg = std::chrono::steady_clock::now();
+  auto run_durations = test_lib::DurationStore{};
+  auto baseline = arg_value(app, "--compare-baseline")
+                    .transform([](auto v) { return test_lib::BaselineStore::load(v); })
+                    .value_or(test_lib::BaselineStore{});
+  auto baseline_config = test_lib::BaselineConfig{};
+  if (auto v = arg_value(app, "--regression-threshold")) {
+    baseline_config.threshold = std::strtod(std::string{v.value()}.c_str(), nullptr) / 100;
+  }
+  auto run_baseline = test_lib::BaselineStore{};
+  uint64_t benchmark_count = 0;
+  /*
+    Regressions are checked by the runner, before it decides whether to fail fast.
+  */
+  auto check_baseline = [&](size_t slot, test_lib::TestResult &res) {
+    if (auto regression = baseline.compare(entries[slot]->name(), res, baseline_config);
+        regression && res.is_ok()) {
+      res.set_error(std::move(regression.value()));
+    }
+  };
+  auto on_result = [&](size_t slot, test_lib::TestResult &&res) {
+    print_skipped_until(ids[slot]);
+    if (res.benchmark()) {
+      benchmark_count += 1;
+    }
+    run_baseline.set(entries[slot]->name(), res);
+    run_durations.set(
+      entries[slot]->name(),
+      std::chrono::duration_cast<std::chrono::nanoseconds>(res.running_time())
+    );
+    if (res.is_ok()) {
+      succ_count += 1;
     } else {
-      std::print(
-        "{}",
-        tui::Layout{}
-          .append_child(
-            tui::Layout{}
-              .style(tui::DomStyle{}.fg(tui::RgbColor::bright_blue()))
-              .append_child(tui::Paragraph{"[{:3}]", i}.no_newline())
-          )
-          .append_child(
-            tui::Layout{}
-              .style(tui::DomStyle{}.fg(tui::RgbColor::bright_yellow()))
-              .append_child(tui::Paragraph{"[{:4}]", "OK!"}.no_newline())
-          )
-          .append_child(tui::Paragraph{"{}", test.get()->name()})
-      );
+      err_count += 1;
     }
+    bus.test_finished(i, entries[slot]->name(), std::move(res));
     i += 1;
-  }
-  ctx.tear_down();
+  };
+  auto on_start = [&](size_t slot) { bus.test_started(ids[slot], entries[slot]->name()); };
+  bool fail_fast = app.args().contains("--fail-fast");
+  size_t jobs = job_count(app, ctx);
   /*
-    Print Statistics
+    Every job may check a property at the same time, the cores are shared between them.
   */
-  std::print(
-    "{}",
-    tui::DomNode::vstack(
+  auto &property_config = test_lib::property_config();
+  property_config.threads = std::max<size_t>(property_config.threads / jobs, 1);
+  if (app.args().contains("--isolate")) {
+    test_lib::IsolatedRunner{jobs, fail_fast}.run(
+      entries, on_result, order, on_start, check_baseline
+    );
+  } else {
+    test_lib::TestRunner{jobs, fail_fast}.run(entries, on_result, order, on_start, check_baseline);
+  }
+  auto run_end = std::chrono::steady_clock::now();
+  durations.commit(durations_path, run_durations);
+  if (auto path = arg_value(app, "--save-baseline")) {
+    run_baseline.save(path.value());
+  }
+  print_skipped_until(ctx.tests.size());
+  ctx.tear_down();
+  bus.run_finished(test_lib::RunSummary{
+    .passed = succ_count,
+    .failed = err_count,
+    .skipped = i - succ_count - err_count,
+    .duration = std::chrono::duration_cast<std::chrono::nanoseconds>(run_end - run_beg),
+    .shard = shard,
+    .seed = test_lib::random_seed()
+  });
+  bus.close();
+  bool uses_baseline =
+    app.args().contains("--compare-baseline") || app.args().contains("--save-baseline");
+  if (uses_baseline && benchmark_count == 0) {
+    std::print(
+      stderr,
+      "{}",
       tui::Layout{}
-        .append_child(
-          tui::Layout{}
-            .style(tui::DomStyle{}.fg(tui::RgbColor::bright_cyan()))
-            .append_child(tui::Paragraph{"{:=<80}", ""})
-        )
-        .append_child(tui::Paragraph{"Ran {:3} tests", succ_count + err_count})
-        .append_child(
-          tui::Layout{}
-            .append_child(
-              tui::Layout{}
-                .style(tui::DomStyle{}.fg(tui::RgbColor::bright_green()))
-                .append_child(tui::Paragraph{"[{:4}]", "OK!"}.no_newline())
-            )
-            .append_child(tui::Paragraph{" {:3} tests", succ_count})
-        )
-        .append_child(
-          tui::Layout{}
-            .append_child(
-              tui::Layout{}
-                .style(tui::DomStyle{}.fg(tui::RgbColor::bright_red()))
-                .append_child(tui::Paragraph{"[{:4}]", "ERR!"}.no_newline())
-            )
-            .append_child(tui::Paragraph{" {:3} tests", err_count})
-        )
-        .append_child(
-          tui::Layout{}
-            .append_child(
-              tui::Layout{}
-                .style(tui::DomStyle{}.fg(tui::RgbColor::bright_yellow()))
-                .append_child(tui::Paragraph{"[{:4}]", "EXC!"}.no_newline())
-            )
-            .append_child(tui::Paragraph{" {:3} tests", i - succ_count - err_count})
-        )
-    )
-  );
+        .style(tui::DomStyle{}.fg(tui::RgbColor::bright_yellow()))
+        .append_child(tui::Paragraph{"no benchmark ran, baselines only apply to benchmarks"})
+    );
+  }
   return err_count;
 }
@@ -0,0 +1,131 @@
+module;
+#include <bit>
+#include <concepts>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <type_traits>
+#if defined(__x86_64__) && (defined(__GNUC__) || defined(__clang__))
+#include <immintrin.h>
+#define JOWI_TEST_LIB_MISMATCH_AVX2 1
+#elif defined(__aarch64__) && defined(__ARM_NEON)
+#include <arm_neon.h>
+#define JOWI_TEST_LIB_MISMATCH_NEON 1
+#endif
+export module jowi.test_lib:mismatch;
+
+namespace jowi::test_lib {
+  /*
+    Types whose equality is the equality of their bytes. Floating points are excluded, 0.0 equals
+    -0.0 and NaN does not equal itself.
+  */
+  template <class T>
+  concept bitwise_comparable =
+    std::is_integral_v<T> || std::is_pointer_v<T> || std::same_as<T, std::byte>;
+
+  /*
+    Compares 8 bytes at a time, the first differing byte is found from the lowest differing bit of
+    the xor of the two words.
+  */
+  size_t first_mismatch_portable(const std::byte *x, const std::byte *y, size_t n) {
+    size_t i = 0;
+    for (; i + sizeof(uint64_t) <= n; i += sizeof(uint64_t)) {
+      uint64_t x_word;
+      uint64_t y_word;
+      std::memcpy(&x_word, x + i, sizeof(uint64_t));
+      std::memcpy(&y_word, y + i, sizeof(uint64_t));
+      if (uint64_t diff = x_word ^ y_word; diff != 0) {
+        int bit = std::endian::native == std::endian::little ? std::countr_zero(diff)
+                                                             : std::countl_zero(diff);
+        return i + static_cast<size_t>(bit) / 8;
+      }
+    }
+    for (; i < n; i += 1) {
+      if (x[i] != y[i]) {
+        return i;
+      }
+    }
+    return n;
+  }
+
+#ifdef JOWI_TEST_LIB_MISMATCH_AVX2
+  /*
+    Checks 128 bytes per iteration with a single branch, the differing vector is only searched
+    once a difference is seen.
+  */
+  __attribute__((target("avx2"))) size_t first_mismatch_avx2(
+    const std::byte *x, const std::byte *y, size_t n
+  ) {
+    size_t i = 0;
+    for (; i + 128 <= n; i += 128) {
+      auto *xv = reinterpret_cast<const __m256i *>(x + i);
+      auto *yv = reinterpret_cast<const __m256i *>(y + i);
+      __m256i d0 = _mm256_xor_si256(_mm256_loadu_si256(xv), _mm256_loadu_si256(yv));
+      __m256i d1 = _mm256_xor_si256(_mm256_loadu_si256(xv + 1), _mm256_loadu_si256(yv + 1));
+      __m256i d2 = _mm256_xor_si256(_mm256_loadu_si256(xv + 2), _mm256_loadu_si256(yv + 2));
+      __m256i d3 = _mm256_xor_si256(_mm256_loadu_si256(xv + 3), _mm256_loadu_si256(yv + 3));
+      __m256i any = _mm256_or_si256(_mm256_or_si256(d0, d1), _mm256_or_si256(d2, d3));
+      if (!_mm256_testz_si256(any, any)) {
+        break;
+      }
+    }
+    for (; i + 32 <= n; i += 32) {
+      __m256i eq = _mm256_cmpeq_epi8(
+        _mm256_loadu_si256(reinterpret_cast<const __m256i *>(x + i)),
+        _mm256_loadu_si256(reinterpret_cast<const __m256i *>(y + i))
+      );
+      auto equal = static_cast<uint32_t>(_mm256_movemask_epi8(eq));
+      if (equal != 0xffffffff) {
+        return i + static_cast<size_t>(std::countr_one(equal));
+      }
+    }
+    return i + first_mismatch_portable(x + i, y + i, n - i);
+  }
+#endif
+
+#ifdef JOWI_TEST_LIB_MISMATCH_NEON
+  size_t first_mismatch_neon(const std::byte *x, const std::byte *y, size_t n) {
+    auto load = [](const std::byte *p) { return vld1q_u8(reinterpret_cast<const uint8_t *>(p)); };
+    size_t i = 0;
+    for (; i + 64 <= n; i += 64) {
+      uint8x16_t e0 = vceqq_u8(load(x + i), load(y + i));
+      uint8x16_t e1 = vceqq_u8(load(x + i + 16), load(y + i + 16));
+      uint8x16_t e2 = vceqq_u8(load(x + i + 32), load(y + i + 32));
+      uint8x16_t e3 = vceqq_u8(load(x + i + 48), load(y + i + 48));
+      if (vminvq_u8(vandq_u8(vandq_u8(e0, e1), vandq_u8(e2, e3))) != 0xff) {
+        break;
+      }
+    }
+    return i + first_mismatch_portable(x + i, y + i, n - i);
+  }
+#endif
+
+  /*
+    The index of the first differing byte of x and y, n when the n bytes are equal. Uses AVX2
+    when the cpu supports it and NEON on aarch64.
+  */
+  size_t first_mismatch_bytes(const std::byte *x, const std::byte *y, size_t n) {
+#if defined(JOWI_TEST_LIB_MISMATCH_AVX2)
+    static const bool has_avx2 = __builtin_cpu_supports("avx2");
+    if (has_avx2) {
+      return first_mismatch_avx2(x, y, n);
+    }
+#elif defined(JOWI_TEST_LIB_MISMATCH_NEON)
+    return first_mismatch_neon(x, y, n);
+#endif
+    return first_mismatch_portable(x, y, n);
+  }
+
+  /*
+    The index of the first differing element of x and y, n when the n elements are equal.
+  */
+  template <bitwise_comparable T> size_t first_mismatch(const T *x, const T *y, size_t n) {
+    if (n == 0 || x == y) {
+      return n;
+    }
+    size_t byte = first_mismatch_bytes(
+      reinterpret_cast<const std::byte *>(x), reinterpret_cast<const std::byte *>(y), n * sizeof(T)
+    );
+    return byte / sizeof(T);
+  }
+}
@@ -0,0 +1,165 @@
+module;
+#if defined(__linux__)
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <optional>
+export module jowi.test_lib:perf;
+
+namespace jowi::test_lib {
+  /*
+    Hardware counters collected while running a test. A counter is std::nullopt when the kernel or
+    the hardware does not allow reading it, e.g. when perf_event_paranoid is too restrictive or the
+    test runs in a virtual machine without a PMU. Benchmarks report the counts per iteration.
+  */
+  export struct PerfCounters {
+    std::optional<double> cycles;
+    std::optional<double> instructions;
+    std::optional<double> branch_misses;
+    std::optional<double> l1d_read_misses;
+    std::optional<double> llc_misses;
+
+    std::optional<double> ipc() const {
+      if (cycles && instructions && cycles.value() > 0) {
+        return instructions.value() / cycles.value();
+      }
+      return std::nullopt;
+    }
+
+    PerfCounters &divide(double n) {
+      auto counters = {&cycles, &instructions, &branch_misses, &l1d_read_misses, &llc_misses};
+      for (auto *counter : counters) {
+        if (counter->has_value() && n > 0) {
+          counter->value() /= n;
+        }
+      }
+      return *this;
+    }
+  };
+
+  /*
+    A group of hardware counters for the calling thread, scheduled together on the PMU such that
+    ratios between them are meaningful. The counters only count between start() and stop().
+  */
+  export struct PerfCounterGroup {
+    PerfCounterGroup() {
+#if defined(__linux__)
+      __fds[0] = open_counter(PERF_TYPE_HARDWARE, PERF_COUNT_HW_CPU_CYCLES, -1);
+      if (__fds[0] == -1) {
+        return;
+      }
+      __fds[1] = open_counter(PERF_TYPE_HARDWARE, PERF_COUNT_HW_INSTRUCTIONS, __fds[0]);
+      __fds[2] = open_counter(PERF_TYPE_HARDWARE, PERF_COUNT_HW_BRANCH_MISSES, __fds[0]);
+      __fds[3] = open_counter(
+        PERF_TYPE_HW_CACHE,
+        PERF_COUNT_HW_CACHE_L1D | (PERF_COUNT_HW_CACHE_OP_READ << 8) |
+          (PERF_COUNT_HW_CACHE_RESULT_MISS << 16),
+        __fds[0]
+      );
+      __fds[4] = open_counter(PERF_TYPE_HARDWARE, PERF_COUNT_HW_CACHE_MISSES, __fds[0]);
+#endif
+    }
+    PerfCounterGroup(const PerfCounterGroup &) = delete;
+    PerfCounterGroup &operator=(const PerfCounterGroup &) = delete;
+    ~PerfCounterGroup() {
+#if defined(__linux__)
+      for (int fd : __fds) {
+        if (fd != -1) {
+          ::close(fd);
+        }
+      }
+#endif
+    }
+
+    bool available() const {
+      return __fds[0] != -1;
+    }
+
+    void start() {
+#if defined(__linux__)
+      if (available()) {
+        ::ioctl(__fds[0], PERF_EVENT_IOC_RESET, PERF_IOC_FLAG_GROUP);
+        ::ioctl(__fds[0], PERF_EVENT_IOC_ENABLE, PERF_IOC_FLAG_GROUP);
+      }
+#endif
+    }
+
+    PerfCounters stop() {
+      PerfCounters counters{};
+#if defined(__linux__)
+      if (!available()) {
+        return counters;
+      }
+      ::ioctl(__fds[0], PERF_EVENT_IOC_DISABLE, PERF_IOC_FLAG_GROUP);
+      // nr, time enabled, time running, then one value per opened counter in opening order.
+      std::array<uint64_t, 3 + counter_count> buf{};
+      if (::read(__fds[0], buf.data(), sizeof(buf)) < static_cast<ssize_t>(3 * sizeof(uint64_t))) {
+        return counters;
+      }
+      // The group is multiplexed when there are more counters than the PMU can hold.
+      double scale =
+        buf[2] == 0 ? 0 : static_cast<double>(buf[1]) / static_cast<double>(buf[2]);
+      std::array<std::optional<double> *, counter_count> targets{
+        &counters.cycles,
+        &counters.instructions,
+        &counters.branch_misses,
+        &counters.l1d_read_misses,
+        &counters.llc_misses
+      };
+      size_t value_id = 0;
+      for (size_t i = 0; i < counter_count && value_id < buf[0]; i += 1) {
+        if (__fds[i] != -1 && scale > 0) {
+          *targets[i] = static_cast<double>(buf[3 + value_id]) * scale;
+        }
+        value_id += __fds[i] != -1;
+      }
+#endif
+      return counters;
+    }
+
+  private:
+    static constexpr size_t counter_count = 5;
+    std::array<int, counter_count> __fds{-1, -1, -1, -1, -1};
+
+#if defined(__linux__)
+    static int open_counter(uint32_t type, uint64_t config, int group_fd) {
+      perf_event_attr attr{};
+      attr.size = sizeof(attr);
+      attr.type = type;
+      attr.config = config;
+      attr.disabled = group_fd == -1;
+      attr.exclude_kernel = 1;
+      attr.exclude_hv = 1;
+      attr.read_format =
+        PERF_FORMAT_GROUP | PERF_FORMAT_TOTAL_TIME_ENABLED | PERF_FORMAT_TOTAL_TIME_RUNNING;
+      long fd = ::syscall(SYS_perf_event_open, &attr, 0, -1, group_fd, PERF_FLAG_FD_CLOEXEC);
+      return fd < 0 ? -1 : static_cast<int>(fd);
+    }
+#endif
+  };
+
+  std::atomic<bool> perf_counters_flag = false;
+
+  /*
+    Enables counting hardware events for every test run afterwards.
+  */
+  export void enable_perf_counters(bool enabled = true) {
+    perf_counters_flag.store(enabled, std::memory_order_relaxed);
+  }
+  export bool perf_counters_enabled() {
+    return perf_counters_flag.load(std::memory_order_relaxed);
+  }
+
+  /*
+    The counter group of the calling thread, opened on first use.
+  */
+  PerfCounterGroup &thread_perf_counters() {
+    thread_local PerfCounterGroup group;
+    return group;
+  }
+}
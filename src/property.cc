@@ -0,0 +1,376 @@
+module;
+#include <algorithm>
+#include <atomic>
+#include <concepts>
+#include <cstddef>
+#include <cstdint>
+#include <exception>
+#include <format>
+#include <limits>
+#include <mutex>
+#include <optional>
+#include <ranges>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+#include <vector>
+export module jowi.test_lib:property;
+import :arena;
+import :exception;
+import :expect;
+import :randomizer;
+import :workload;
+
+namespace jowi::test_lib {
+  /*
+    A generator of property arguments : draws a value from a Generator and lists simpler values
+    to try when shrinking a failing value, the most aggressive simplifications first.
+  */
+  export template <class G>
+  concept arbitrary = requires(const G &g, const Generator &gen, const typename G::value_type &v) {
+    { g(gen) } -> std::same_as<typename G::value_type>;
+    { g.shrink(v) } -> std::same_as<std::vector<typename G::value_type>>;
+  };
+
+  /*
+    Integers in [min, max], shrinking towards the value of the range closest to 0.
+  */
+  export template <std::integral T> struct IntegerGen {
+    using value_type = T;
+    T min;
+    T max;
+
+    T operator()(const Generator &gen) const {
+      return random_integer(min, max, gen);
+    }
+
+    std::vector<T> shrink(T v) const {
+      T target = std::clamp(T{0}, min, max);
+      std::vector<T> candidates;
+      if (v == target) {
+        return candidates;
+      }
+      candidates.push_back(target);
+      // target and v are on the same side of 0 unless target is 0, v - target never overflows.
+      for (T diff = static_cast<T>((v - target) / 2); diff != 0; diff /= 2) {
+        if (static_cast<T>(v - diff) != target) {
+          candidates.push_back(static_cast<T>(v - diff));
+        }
+      }
+      return candidates;
+    }
+  };
+
+  /*
+    Removes chunks of size, size / 2, ..., 1 elements while keeping at least min_size of them.
+  */
+  template <class V> void push_removals(std::vector<V> &candidates, const V &v, size_t min_size) {
+    for (size_t chunk = v.size() - min_size; chunk > 0; chunk /= 2) {
+      for (size_t beg = 0; beg + chunk <= v.size(); beg += chunk) {
+        V smaller;
+        smaller.reserve(v.size() - chunk);
+        smaller.insert(smaller.end(), v.begin(), v.begin() + beg);
+        smaller.insert(smaller.end(), v.begin() + beg + chunk, v.end());
+        candidates.push_back(std::move(smaller));
+      }
+    }
+  }
+
+  /*
+    Strings of [min_size, max_size] characters taken from choices, shrinking by removing
+    characters then by replacing them with the first choice.
+  */
+  export struct StringGen {
+    using value_type = std::string;
+    size_t min_size;
+    size_t max_size;
+    std::string_view choices = ascii_lowercase;
+
+    std::string operator()(const Generator &gen) const {
+      return random_string(random_integer(min_size, max_size, gen), choices, gen);
+    }
+
+    std::vector<std::string> shrink(const std::string &v) const {
+      std::vector<std::string> candidates;
+      push_removals(candidates, v, min_size);
+      for (size_t i = 0; i < v.size(); i += 1) {
+        if (v[i] != choices.front()) {
+          candidates.push_back(v);
+          candidates.back()[i] = choices.front();
+        }
+      }
+      return candidates;
+    }
+  };
+
+  /*
+    Vectors of [min_size, max_size] elements drawn from element, shrinking by removing elements
+    then by shrinking single elements.
+  */
+  export template <arbitrary G> struct VectorGen {
+    using value_type = std::vector<typename G::value_type>;
+    G element;
+    size_t min_size;
+    size_t max_size;
+
+    value_type operator()(const Generator &gen) const {
+      value_type v;
+      size_t size = random_integer(min_size, max_size, gen);
+      v.reserve(size);
+      for (size_t i = 0; i < size; i += 1) {
+        v.push_back(element(gen));
+      }
+      return v;
+    }
+
+    std::vector<value_type> shrink(const value_type &v) const {
+      // Only the first few simplifications of every element, large vectors have many elements.
+      constexpr size_t per_element = 4;
+      std::vector<value_type> candidates;
+      push_removals(candidates, v, min_size);
+      for (size_t i = 0; i < v.size(); i += 1) {
+        auto simpler = element.shrink(v[i]);
+        for (size_t c = 0; c < std::min(simpler.size(), per_element); c += 1) {
+          candidates.push_back(v);
+          candidates.back()[i] = std::move(simpler[c]);
+        }
+      }
+      return candidates;
+    }
+  };
+
+  /*
+    Tuples of one value per generator, shrinking one component at a time.
+  */
+  export template <arbitrary... Gs> struct TupleGen {
+    using value_type = std::tuple<typename Gs::value_type...>;
+    std::tuple<Gs...> elements;
+
+    value_type operator()(const Generator &gen) const {
+      // Braced initialization draws the components in order.
+      return std::apply([&](const auto &...g) { return value_type{g(gen)...}; }, elements);
+    }
+
+    std::vector<value_type> shrink(const value_type &v) const {
+      std::vector<value_type> candidates;
+      [&]<size_t... is>(std::index_sequence<is...>) {
+        (push_component<is>(candidates, v), ...);
+      }(std::index_sequence_for<Gs...>{});
+      return candidates;
+    }
+
+  private:
+    template <size_t i>
+    void push_component(std::vector<value_type> &candidates, const value_type &v) const {
+      for (auto &simpler : std::get<i>(elements).shrink(std::get<i>(v))) {
+        candidates.push_back(v);
+        std::get<i>(candidates.back()) = std::move(simpler);
+      }
+    }
+  };
+
+  export template <std::integral T> IntegerGen<T> integers(T min, T max) {
+    return IntegerGen<T>{min, max};
+  }
+  export StringGen strings(
+    size_t min_size, size_t max_size, std::string_view choices = ascii_lowercase
+  ) {
+    return StringGen{min_size, max_size, choices};
+  }
+  export template <arbitrary G>
+  VectorGen<G> vectors_of(G element, size_t min_size, size_t max_size) {
+    return VectorGen<G>{std::move(element), min_size, max_size};
+  }
+  export template <arbitrary... Gs> TupleGen<Gs...> tuples_of(Gs... elements) {
+    return TupleGen<Gs...>{std::tuple{std::move(elements)...}};
+  }
+
+  /*
+    Formats a property argument for the counterexample : strings are quoted, ranges and tuples are
+    formatted element by element.
+  */
+  template <class T> std::string describe(const T &v) {
+    if constexpr (std::convertible_to<const T &, std::string_view>) {
+      return std::format("\"{}\"", std::string_view{v});
+    } else if constexpr (std::ranges::input_range<const T>) {
+      std::string out = "[";
+      for (const auto &e : v) {
+        out += out.size() == 1 ? "" : ", ";
+        out += describe(e);
+      }
+      return out + "]";
+    } else if constexpr (requires { std::tuple_size<T>::value; }) {
+      return std::apply(
+        [](const auto &...e) {
+          std::string out = "(";
+          ((out += out.size() == 1 ? "" : ", ", out += describe(e)), ...);
+          return out + ")";
+        },
+        v
+      );
+    } else if constexpr (std::formattable<T, char>) {
+      return std::format("{}", v);
+    } else {
+      return "<unformattable>";
+    }
+  }
+
+  export struct PropertyConfig {
+    /*
+      The amount of cases generated per property.
+    */
+    size_t cases = 100;
+    /*
+      The most candidates tried while shrinking a counterexample.
+    */
+    size_t max_shrinks = 1000;
+    /*
+      The threads cases are spread across. The runner divides them between its jobs.
+    */
+    size_t threads = std::max(std::thread::hardware_concurrency(), 1u);
+  };
+
+  /*
+    The configuration of every property, --property-cases sets the amount of cases.
+  */
+  export PropertyConfig &property_config() {
+    static PropertyConfig config{};
+    return config;
+  }
+
+  /*
+    Runs the property on one case, on the calling thread. The generator of the thread is seeded
+    with the seed of the case, so randomness inside the property is reproduced while shrinking.
+    Failed expectations fail the case like a thrown assertion.
+  */
+  template <class F, class Args>
+  std::optional<ExceptionInfo> run_case(F &f, const Args &args, uint64_t seed) {
+    auto seeded = SeedScope{seed};
+    auto expectations = ExpectScope{};
+    auto arena = ArenaScope{};
+    std::optional<ExceptionInfo> err;
+    try {
+      std::apply(f, args);
+    } catch (...) {
+      try {
+        err = translate_exception(std::current_exception());
+      } catch (...) {
+        err = ExceptionInfo{"unknown", "an exception not deriving from std::exception"};
+      }
+    }
+    arena.release();
+    if (auto failed = expectations.take(); failed && !err) {
+      err = std::move(failed);
+    }
+    return err;
+  }
+
+  /*
+    Checks that f holds for config.cases argument sets drawn from gens. Cases are spread across
+    worker threads, case i is drawn from a seed derived from the generator of the test and i, so
+    the first failing case does not depend on the amount of threads. f is therefore called
+    concurrently. The first failing case is shrunk to a minimal counterexample, reported with its
+    seed through a FailAssertion.
+  */
+  export template <class F, arbitrary... Gs>
+    requires(std::invocable<F &, const typename Gs::value_type &...>)
+  void check_property(F &&f, const Gs &...gens) {
+    using args_type = std::tuple<typename Gs::value_type...>;
+    const auto config = property_config();
+    uint64_t base = thread_generator().gen();
+    auto case_seed = [&](size_t i) {
+      uint64_t state = base + i;
+      return splitmix64(state);
+    };
+    auto draw = [&](uint64_t seed) {
+      auto seeded = SeedScope{seed};
+      return args_type{gens(thread_generator())...};
+    };
+
+    std::atomic<size_t> next = 0;
+    std::atomic<size_t> first_failure = std::numeric_limits<size_t>::max();
+    std::mutex failure_mut;
+    std::optional<std::pair<args_type, ExceptionInfo>> failure;
+    auto work = [&]() {
+      while (true) {
+        size_t i = next.fetch_add(1, std::memory_order_relaxed);
+        if (i >= config.cases || i > first_failure.load(std::memory_order_acquire)) {
+          return;
+        }
+        auto args = draw(case_seed(i));
+        if (auto err = run_case(f, args, case_seed(i))) {
+          std::lock_guard l{failure_mut};
+          if (i < first_failure.load(std::memory_order_relaxed)) {
+            first_failure.store(i, std::memory_order_release);
+            failure.emplace(std::move(args), std::move(err.value()));
+          }
+        }
+      }
+    };
+    {
+      std::vector<std::jthread> workers;
+      for (size_t t = 1; t < std::min(config.threads, config.cases); t += 1) {
+        workers.emplace_back(work);
+      }
+      work();
+    }
+    if (!failure) {
+      return;
+    }
+
+    auto [args, err] = std::move(failure.value());
+    size_t index = first_failure.load();
+    uint64_t seed = case_seed(index);
+    auto shrinker = TupleGen<Gs...>{std::tuple{gens...}};
+    size_t steps = 0;
+    size_t attempts = 0;
+    for (bool shrunk = true; shrunk && attempts < config.max_shrinks;) {
+      shrunk = false;
+      auto candidates = shrinker.shrink(args);
+      for (auto &candidate : candidates) {
+        attempts += 1;
+        if (auto candidate_err = run_case(f, candidate, seed)) {
+          args = std::move(candidate);
+          err = std::move(candidate_err.value());
+          steps += 1;
+          shrunk = true;
+          break;
+        }
+        if (attempts >= config.max_shrinks) {
+          break;
+        }
+      }
+    }
+    throw FailAssertion{std::format(
+      "Property falsified by case {} of {} (case seed {}), shrunk {} times to : {}\n{} : {}",
+      index,
+      config.cases,
+      seed,
+      steps,
+      std::apply(
+        [](const auto &...a) {
+          std::string out;
+          ((out += out.empty() ? "" : ", ", out += describe(a)), ...);
+          return out;
+        },
+        args
+      ),
+      err.name,
+      err.message
+    )};
+  }
+
+  template <class T> struct property_function;
+  template <class... Gs> struct property_function<std::tuple<Gs...>> {
+    using type = void(const typename Gs::value_type &...);
+  };
+
+  /*
+    The type of the property function of JOWI_ADD_PROPERTY : one const reference parameter per
+    generator.
+  */
+  export template <class T> using property_function_t = typename property_function<T>::type;
+}
@@ -0,0 +1,373 @@
+module;
+#include <algorithm>
+#include <array>
+#include <bit>
+#include <concepts>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <limits>
+#include <span>
+#include <stdexcept>
+#include <string_view>
+#include <thread>
+#include <type_traits>
+#include <vector>
+#if defined(__x86_64__) && (defined(__GNUC__) || defined(__clang__))
+#include <immintrin.h>
+#define JOWI_TEST_LIB_PHILOX_AVX2 1
+#endif
+export module jowi.test_lib:random_stream;
+import :randomizer;
+
+namespace jowi::test_lib {
+  /*
+    The Philox4x32-10 block function (Salmon et al., Parallel Random Numbers: As Easy as 1, 2,
+    3). It maps a 128 bit counter and a 64 bit key to 128 random bits, so any block of a stream can
+    be computed without computing the blocks before it.
+  */
+  export struct Philox4x32 {
+    using counter_type = std::array<uint32_t, 4>;
+    using key_type = std::array<uint32_t, 2>;
+
+    static constexpr uint32_t multiplier_0 = 0xD2511F53;
+    static constexpr uint32_t multiplier_1 = 0xCD9E8D57;
+    static constexpr uint32_t weyl_0 = 0x9E3779B9;
+    static constexpr uint32_t weyl_1 = 0xBB67AE85;
+    static constexpr int rounds = 10;
+
+    static constexpr counter_type block(counter_type ctr, key_type key) {
+      for (int r = 0; r < rounds; r += 1) {
+        uint64_t p0 = static_cast<uint64_t>(multiplier_0) * ctr[0];
+        uint64_t p1 = static_cast<uint64_t>(multiplier_1) * ctr[2];
+        ctr = {
+          static_cast<uint32_t>(p1 >> 32) ^ ctr[1] ^ key[0],
+          static_cast<uint32_t>(p1),
+          static_cast<uint32_t>(p0 >> 32) ^ ctr[3] ^ key[1],
+          static_cast<uint32_t>(p0)
+        };
+        key[0] += weyl_0;
+        key[1] += weyl_1;
+      }
+      return ctr;
+    }
+  };
+
+  /*
+    Writes the blocks [first, first + count) of a stream into out, 4 words per block. Block n has
+    the counter {n, stream id}.
+  */
+  void philox_blocks_portable(
+    Philox4x32::key_type key, uint64_t id, uint64_t first, size_t count, uint32_t *out
+  ) {
+    for (size_t b = 0; b < count; b += 1) {
+      uint64_t n = first + b;
+      auto words = Philox4x32::block(
+        {static_cast<uint32_t>(n),
+         static_cast<uint32_t>(n >> 32),
+         static_cast<uint32_t>(id),
+         static_cast<uint32_t>(id >> 32)},
+        key
+      );
+      std::memcpy(out + 4 * b, words.data(), sizeof(words));
+    }
+  }
+
+#ifdef JOWI_TEST_LIB_PHILOX_AVX2
+  /*
+    Computes 8 blocks at once, every register holds the same word of 8 consecutive counters.
+  */
+  __attribute__((target("avx2"))) void philox_blocks_avx2(
+    Philox4x32::key_type key, uint64_t id, uint64_t first, size_t count, uint32_t *out
+  ) {
+    const __m256i m0 = _mm256_set1_epi64x(Philox4x32::multiplier_0);
+    const __m256i m1 = _mm256_set1_epi64x(Philox4x32::multiplier_1);
+    const __m256i lanes = _mm256_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7);
+    size_t b = 0;
+    for (; b + 8 <= count; b += 8) {
+      uint64_t n = first + b;
+      // The low word must not wrap within the group, the portable kernel carries it.
+      if (static_cast<uint32_t>(n) > UINT32_MAX - 7) {
+        philox_blocks_portable(key, id, n, 8, out + 4 * b);
+        continue;
+      }
+      __m256i c0 = _mm256_add_epi32(_mm256_set1_epi32(static_cast<int>(n)), lanes);
+      __m256i c1 = _mm256_set1_epi32(static_cast<int>(n >> 32));
+      __m256i c2 = _mm256_set1_epi32(static_cast<int>(id));
+      __m256i c3 = _mm256_set1_epi32(static_cast<int>(id >> 32));
+      uint32_t k0 = key[0];
+      uint32_t k1 = key[1];
+      for (int r = 0; r < Philox4x32::rounds; r += 1) {
+        __m256i p0_even = _mm256_mul_epu32(c0, m0);
+        __m256i p0_odd = _mm256_mul_epu32(_mm256_srli_epi64(c0, 32), m0);
+        __m256i p1_even = _mm256_mul_epu32(c2, m1);
+        __m256i p1_odd = _mm256_mul_epu32(_mm256_srli_epi64(c2, 32), m1);
+        __m256i lo0 = _mm256_blend_epi32(p0_even, _mm256_slli_epi64(p0_odd, 32), 0b10101010);
+        __m256i hi0 = _mm256_blend_epi32(_mm256_srli_epi64(p0_even, 32), p0_odd, 0b10101010);
+        __m256i lo1 = _mm256_blend_epi32(p1_even, _mm256_slli_epi64(p1_odd, 32), 0b10101010);
+        __m256i hi1 = _mm256_blend_epi32(_mm256_srli_epi64(p1_even, 32), p1_odd, 0b10101010);
+        c0 = _mm256_xor_si256(_mm256_xor_si256(hi1, c1), _mm256_set1_epi32(static_cast<int>(k0)));
+        c1 = lo1;
+        c2 = _mm256_xor_si256(_mm256_xor_si256(hi0, c3), _mm256_set1_epi32(static_cast<int>(k1)));
+        c3 = lo0;
+        k0 += Philox4x32::weyl_0;
+        k1 += Philox4x32::weyl_1;
+      }
+      // Transposes the 4 x 8 words back into 8 consecutive blocks.
+      __m256i t0 = _mm256_unpacklo_epi32(c0, c1);
+      __m256i t1 = _mm256_unpacklo_epi32(c2, c3);
+      __m256i t2 = _mm256_unpackhi_epi32(c0, c1);
+      __m256i t3 = _mm256_unpackhi_epi32(c2, c3);
+      __m256i u0 = _mm256_unpacklo_epi64(t0, t1);
+      __m256i u1 = _mm256_unpackhi_epi64(t0, t1);
+      __m256i u2 = _mm256_unpacklo_epi64(t2, t3);
+      __m256i u3 = _mm256_unpackhi_epi64(t2, t3);
+      auto *dst = reinterpret_cast<__m256i *>(out + 4 * b);
+      _mm256_storeu_si256(dst, _mm256_permute2x128_si256(u0, u1, 0x20));
+      _mm256_storeu_si256(dst + 1, _mm256_permute2x128_si256(u2, u3, 0x20));
+      _mm256_storeu_si256(dst + 2, _mm256_permute2x128_si256(u0, u1, 0x31));
+      _mm256_storeu_si256(dst + 3, _mm256_permute2x128_si256(u2, u3, 0x31));
+    }
+    philox_blocks_portable(key, id, first + b, count - b, out + 4 * b);
+  }
+#endif
+
+  void philox_blocks(
+    Philox4x32::key_type key, uint64_t id, uint64_t first, size_t count, uint32_t *out
+  ) {
+#ifdef JOWI_TEST_LIB_PHILOX_AVX2
+    static const bool has_avx2 = __builtin_cpu_supports("avx2");
+    if (has_avx2) {
+      philox_blocks_avx2(key, id, first, count, out);
+      return;
+    }
+#endif
+    philox_blocks_portable(key, id, first, count, out);
+  }
+
+  /*
+    A counter based stream of random numbers. Element i of the stream only depends on the seed,
+    the id of the stream and i, so ranges of a stream can be generated in any order and on any
+    amount of threads with the same result. Element i is made of the words 2i and 2i + 1 of the
+    stream, block n holds the words [4n, 4n + 4).
+  */
+  export struct RandomStream {
+    explicit constexpr RandomStream(uint64_t seed, uint64_t id = 0) : __seed{seed}, __id{id} {}
+
+    /*
+      A stream seeded from a generator, by default the generator of the test.
+    */
+    explicit RandomStream(const Generator &gen = thread_generator()) :
+      __seed{gen.gen()}, __id{0} {}
+
+    constexpr uint64_t seed() const {
+      return __seed;
+    }
+    constexpr uint64_t id() const {
+      return __id;
+    }
+
+    /*
+      A child stream, independent from this stream and from the other children.
+    */
+    constexpr RandomStream split(uint64_t child) const {
+      uint64_t state = __id * 0x9e3779b97f4a7c15 + child + 1;
+      return RandomStream{__seed, splitmix64(state)};
+    }
+
+    constexpr Philox4x32::counter_type block(uint64_t n) const {
+      return Philox4x32::block(
+        {static_cast<uint32_t>(n),
+         static_cast<uint32_t>(n >> 32),
+         static_cast<uint32_t>(__id),
+         static_cast<uint32_t>(__id >> 32)},
+        key()
+      );
+    }
+
+    constexpr uint64_t operator[](uint64_t i) const {
+      auto words = block(i / 2);
+      size_t w = 2 * (i % 2);
+      return static_cast<uint64_t>(words[w]) | (static_cast<uint64_t>(words[w + 1]) << 32);
+    }
+
+    /*
+      Writes the blocks [first, first + count) into out, 4 words per block, with the widest
+      kernel the cpu supports.
+    */
+    void generate(uint64_t first, size_t count, uint32_t *out) const {
+      philox_blocks(key(), __id, first, count, out);
+    }
+
+  private:
+    uint64_t __seed;
+    uint64_t __id;
+
+    constexpr Philox4x32::key_type key() const {
+      return {static_cast<uint32_t>(__seed), static_cast<uint32_t>(__seed >> 32)};
+    }
+  };
+
+  constexpr uint64_t mul_high(uint64_t a, uint64_t b) {
+#if defined(__SIZEOF_INT128__)
+    return static_cast<uint64_t>((static_cast<unsigned __int128>(a) * b) >> 64);
+#else
+    uint64_t a_lo = a & 0xffffffff;
+    uint64_t a_hi = a >> 32;
+    uint64_t b_lo = b & 0xffffffff;
+    uint64_t b_hi = b >> 32;
+    uint64_t mid = (a_lo * b_lo >> 32) + (a_hi * b_lo & 0xffffffff) + a_lo * b_hi;
+    return a_hi * b_hi + (a_hi * b_lo >> 32) + (mid >> 32);
+#endif
+  }
+
+  /*
+    Maps 64 random bits to a value. Distributions are pure functions of the bits, which keeps bulk
+    generation reproducible.
+  */
+  export template <class D>
+  concept random_distribution = requires(const D &d, uint64_t bits) {
+    typename D::result_type;
+    { d(bits) } -> std::convertible_to<typename D::result_type>;
+  };
+
+  /*
+    Integers uniform in [a, b], by scaling the bits with a multiplication (Lemire). The bias is
+    at most (b - a + 1) / 2^64.
+  */
+  export template <std::integral T> struct UniformInt {
+    using result_type = T;
+    T a;
+    T b;
+
+    constexpr T operator()(uint64_t bits) const {
+      using U = std::make_unsigned_t<T>;
+      uint64_t range = static_cast<uint64_t>(static_cast<U>(b) - static_cast<U>(a)) + 1;
+      uint64_t offset = range == 0 ? bits : mul_high(bits, range);
+      return static_cast<T>(static_cast<U>(static_cast<U>(a) + static_cast<U>(offset)));
+    }
+  };
+
+  /*
+    Reals uniform in [a, b), using as many bits as the mantissa holds, at most the 64 bits drawn
+    for every element, e.g. for long double.
+  */
+  export template <std::floating_point T> struct UniformReal {
+    using result_type = T;
+    T a;
+    T b;
+
+    constexpr T operator()(uint64_t bits) const {
+      constexpr int digits = std::min(std::numeric_limits<T>::digits, 64);
+      // 2^digits overflows uint64_t when digits is 64, it is built from 2^(digits - 1).
+      constexpr T scale = static_cast<T>(uint64_t{1} << (digits - 1)) * 2;
+      T unit = static_cast<T>(bits >> (64 - digits)) / scale;
+      return a + (b - a) * unit;
+    }
+  };
+
+  /*
+    Uniformly picks one of the choices, e.g. UniformChoice{ascii_lowercase} for strings. The
+    choices must outlive the distribution, and cannot be empty.
+  */
+  export template <class T> struct UniformChoice {
+    using result_type = T;
+    std::span<const T> choices;
+
+    constexpr UniformChoice(std::span<const T> choices) : choices{choices} {
+      if (choices.empty()) {
+        throw std::invalid_argument{"UniformChoice needs at least one choice"};
+      }
+    }
+
+    constexpr T operator()(uint64_t bits) const {
+      return choices[mul_high(bits, choices.size())];
+    }
+  };
+  export UniformChoice(std::string_view) -> UniformChoice<char>;
+
+  /*
+    Splits [0, size) into chunks of a multiple of granule and runs work(beg, end) on each of them,
+    on up to threads threads. The calling thread takes the last chunk.
+  */
+  template <class F> void split_work(size_t size, size_t threads, size_t granule, F &&work) {
+    size_t per_thread = (size + std::max<size_t>(threads, 1) - 1) / std::max<size_t>(threads, 1);
+    per_thread = std::max((per_thread + granule - 1) / granule * granule, granule);
+    std::vector<std::jthread> workers;
+    size_t beg = 0;
+    for (; size - beg > per_thread; beg += per_thread) {
+      workers.emplace_back([&work, beg, per_thread]() { work(beg, beg + per_thread); });
+    }
+    work(beg, size);
+  }
+
+  /*
+    Blocks generated at once into a buffer on the stack.
+  */
+  constexpr size_t chunk_blocks = 256;
+
+  template <class T, random_distribution D>
+  void fill_elements(std::span<T> out, uint64_t first, const D &dist, const RandomStream &stream) {
+    alignas(32) std::array<uint32_t, 4 * chunk_blocks> words;
+    size_t done = 0;
+    while (done < out.size()) {
+      uint64_t elem = first + done;
+      size_t skip = elem % 2;
+      size_t blocks = std::min(chunk_blocks, (skip + out.size() - done + 1) / 2);
+      stream.generate(elem / 2, blocks, words.data());
+      size_t count = std::min(2 * blocks - skip, out.size() - done);
+      for (size_t k = 0; k < count; k += 1) {
+        size_t w = 2 * (skip + k);
+        uint64_t bits =
+          static_cast<uint64_t>(words[w]) | (static_cast<uint64_t>(words[w + 1]) << 32);
+        out[done + k] = static_cast<T>(dist(bits));
+      }
+      done += count;
+    }
+  }
+
+  void fill_bytes(std::span<std::byte> out, uint64_t first, const RandomStream &stream) {
+    alignas(32) std::array<uint32_t, 4 * chunk_blocks> words;
+    size_t done = 0;
+    while (done < out.size()) {
+      uint64_t byte = first + done;
+      size_t skip = byte % 16;
+      size_t blocks = std::min(chunk_blocks, (skip + out.size() - done + 15) / 16);
+      stream.generate(byte / 16, blocks, words.data());
+      if constexpr (std::endian::native == std::endian::big) {
+        for (auto &w : words) {
+          w = std::byteswap(w);
+        }
+      }
+      size_t count = std::min(16 * blocks - skip, out.size() - done);
+      auto *bytes = reinterpret_cast<const std::byte *>(words.data());
+      std::memcpy(out.data() + done, bytes + skip, count);
+      done += count;
+    }
+  }
+
+  /*
+    Fills out with element [0, out.size()) of the stream mapped through dist. The work is split
+    across up to threads threads, the output only depends on the stream and dist.
+  */
+  export template <class T, random_distribution D>
+    requires(std::convertible_to<typename D::result_type, T>)
+  void random_fill(
+    std::span<T> out, const D &dist, const RandomStream &stream = RandomStream{}, size_t threads = 1
+  ) {
+    split_work(out.size(), threads, 16 * 1024, [&](size_t beg, size_t end) {
+      fill_elements(out.subspan(beg, end - beg), beg, dist, stream);
+    });
+  }
+
+  /*
+    Fills out with the bytes of the stream, the words of the stream in little endian order.
+  */
+  export void random_bytes(
+    std::span<std::byte> out, const RandomStream &stream = RandomStream{}, size_t threads = 1
+  ) {
+    split_work(out.size(), threads, 64 * 1024, [&](size_t beg, size_t end) {
+      fill_bytes(out.subspan(beg, end - beg), beg, stream);
+    });
+  }
+}
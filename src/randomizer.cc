@@ -1,7 +1,13 @@
 module;
+#include <array>
+#include <atomic>
+#include <bit>
+#include <cstdint>
+#include <limits>
 #include <random>
 #include <ranges>
 #include <string>
+#include <string_view>
 
 export module jowi.test_lib:randomizer;
 
@@ -34,14 +40,146 @@ namespace jowi::test_lib {
     std::string_view{ascii_letters.begin() + 52, ascii_letters.begin() + 62};
 
   /*
-    This creates an internal random number Generator.
+    Advances state and returns the next output of SplitMix64, used to expand a single seed into
+    the state of a generator.
+  */
+  constexpr uint64_t splitmix64(uint64_t &state) {
+    state += 0x9e3779b97f4a7c15;
+    uint64_t z = state;
+    z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9;
+    z = (z ^ (z >> 27)) * 0x94d049bb133111eb;
+    return z ^ (z >> 31);
+  }
+
+  /*
+    The xoshiro256** engine : 32 bytes of state, a handful of instructions per 64 bit output and
+    good statistical quality. Satisfies std::uniform_random_bit_generator, so it can drive the
+    standard distributions.
+  */
+  export struct Xoshiro256 {
+    using result_type = uint64_t;
+
+    explicit constexpr Xoshiro256(uint64_t seed = 0) {
+      this->seed(seed);
+    }
+
+    constexpr void seed(uint64_t seed) {
+      for (auto &s : __state) {
+        s = splitmix64(seed);
+      }
+    }
+
+    static constexpr result_type min() {
+      return 0;
+    }
+    static constexpr result_type max() {
+      return std::numeric_limits<result_type>::max();
+    }
+
+    constexpr result_type operator()() {
+      auto result = std::rotl(__state[1] * 5, 7) * 9;
+      auto t = __state[1] << 17;
+      __state[2] ^= __state[0];
+      __state[3] ^= __state[1];
+      __state[1] ^= __state[2];
+      __state[0] ^= __state[3];
+      __state[2] ^= t;
+      __state[3] = std::rotl(__state[3], 45);
+      return result;
+    }
+
+  private:
+    std::array<uint64_t, 4> __state{};
+  };
+
+  uint64_t nondeterministic_seed() {
+    std::random_device rd;
+    return (static_cast<uint64_t>(rd()) << 32) ^ rd();
+  }
+
+  std::atomic<uint64_t> &seed_storage() {
+    static std::atomic<uint64_t> seed{nondeterministic_seed()};
+    return seed;
+  }
+
+  /*
+    The seed of the run. It is random unless set through set_random_seed (--seed), and it is
+    printed when tests fail so that the run can be reproduced.
+  */
+  export uint64_t random_seed() {
+    return seed_storage().load(std::memory_order_relaxed);
+  }
+
+  /*
+    The seed a test is run with, derived from the seed of the run and the name of the test. It
+    does not depend on the thread or the order the tests are run in.
+  */
+  export uint64_t test_seed(std::string_view name) {
+    // FNV-1a, stable across platforms unlike std::hash.
+    uint64_t hash = 0xcbf29ce484222325;
+    for (char c : name) {
+      hash = (hash ^ static_cast<unsigned char>(c)) * 0x100000001b3;
+    }
+    uint64_t state = random_seed() ^ hash;
+    return splitmix64(state);
+  }
+
+  /*
+    A random number Generator. Prefer thread_generator() to constructing one, which is cheap
+    but draws its seed from std::random_device.
   */
   export struct Generator {
-    mutable std::random_device rd;
-    mutable std::mt19937 gen;
+    mutable Xoshiro256 gen;
+
+    Generator() : gen{nondeterministic_seed()} {}
+    explicit Generator(uint64_t seed) : gen{seed} {}
+
+    void seed(uint64_t seed) const {
+      gen.seed(seed);
+    }
+  };
+
+  /*
+    The generator of the calling thread, the default of every random function below. The runner
+    reseeds it with test_seed() before every test, so a test draws the same values for the same
+    seed.
+  */
+  export const Generator &thread_generator() {
+    static std::atomic<uint64_t> threads = 0;
+    thread_local Generator gen{[]() {
+      uint64_t state = random_seed() + threads.fetch_add(1, std::memory_order_relaxed);
+      return splitmix64(state);
+    }()};
+    return gen;
+  }
+
+  /*
+    Seeds the generator of the calling thread while it lives and restores its previous state
+    afterwards, so a test run from within another test does not change the values the other test
+    draws next.
+  */
+  class SeedScope {
+    Xoshiro256 __outer;
 
-    Generator() : rd{}, gen{rd()} {}
+  public:
+    explicit SeedScope(uint64_t seed) : __outer{thread_generator().gen} {
+      thread_generator().seed(seed);
+    }
+    SeedScope(const SeedScope &) = delete;
+    SeedScope &operator=(const SeedScope &) = delete;
+    ~SeedScope() {
+      thread_generator().gen = __outer;
+    }
   };
+
+  /*
+    Sets the seed of the run and reseeds the generator of the calling thread with it.
+  */
+  export void set_random_seed(uint64_t seed) {
+    seed_storage().store(seed, std::memory_order_relaxed);
+    thread_generator().seed(seed);
+  }
+
   /*
     Random Algorithms using the Generator defined above.
   */
@@ -53,7 +191,7 @@ namespace jowi::test_lib {
   export template <std::ranges::forward_range T>
     requires(std::convertible_to<std::ranges::range_size_t<T>, size_t>)
   const std::ranges::range_value_t<T> &random_pick(
-    const T &container, const Generator &gen = Generator{}
+    const T &container, const Generator &gen = thread_generator()
   ) {
     const auto begin = std::ranges::begin(container);
     const auto end = std::ranges::end(container);
@@ -64,20 +202,24 @@ namespace jowi::test_lib {
   }
 
   export std::string random_string(
-    size_t length, std::string_view choices = ascii_lowercase, const Generator &gen = Generator{}
+    size_t length,
+    std::string_view choices = ascii_lowercase,
+    const Generator &gen = thread_generator()
   ) {
     std::string generated_str;
     generated_str.reserve(length);
+    std::uniform_int_distribution<size_t> distrib{0, choices.size() - 1};
     for (size_t i = 0; i < length; i += 1)
-      generated_str.push_back(random_pick(choices));
+      generated_str.push_back(choices[distrib(gen.gen)]);
     return generated_str;
   }
-  export template <std::integral T> T random_integer(T a, T b, const Generator &gen = Generator{}) {
+  export template <std::integral T>
+  T random_integer(T a, T b, const Generator &gen = thread_generator()) {
     std::uniform_int_distribution<T> distribution{a, b};
     return distribution(gen.gen);
   }
   export template <std::floating_point T>
-  T random_real(T a, T b, const Generator &gen = Generator{}) {
+  T random_real(T a, T b, const Generator &gen = thread_generator()) {
     std::uniform_real_distribution<T> distribution{a, b};
     return distribution(gen.gen);
   }
@@ -0,0 +1,299 @@
+module;
+#include <chrono>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <format>
+#include <iterator>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <utility>
+export module jowi.test_lib:Reporter;
+import :alloc;
+import :BufferedWriter;
+import :EventBus;
+import :exception;
+import :perf;
+import :reflection;
+import :resources;
+import :statistics;
+import :TestEntry;
+
+namespace jowi::test_lib {
+  void append_json_string(std::string &out, std::string_view v) {
+    out.push_back('"');
+    for (char c : v) {
+      switch (c) {
+        case '"':
+          out.append("\\\"");
+          break;
+        case '\\':
+          out.append("\\\\");
+          break;
+        case '\n':
+          out.append("\\n");
+          break;
+        case '\r':
+          out.append("\\r");
+          break;
+        case '\t':
+          out.append("\\t");
+          break;
+        default:
+          if (static_cast<unsigned char>(c) < 0x20) {
+            std::format_to(std::back_inserter(out), "\\u{:04x}", static_cast<unsigned>(c));
+          } else {
+            out.push_back(c);
+          }
+      }
+    }
+    out.push_back('"');
+  }
+
+  std::string json_string(std::string_view v) {
+    std::string out;
+    out.reserve(v.size() + 2);
+    append_json_string(out, v);
+    return out;
+  }
+
+  /*
+    JSON has no representation for NaN and infinities.
+  */
+  std::string json_number(std::optional<double> v) {
+    if (!v || !std::isfinite(v.value())) {
+      return "null";
+    }
+    return std::format("{}", v.value());
+  }
+
+  std::string xml_escape(std::string_view v) {
+    std::string out;
+    out.reserve(v.size());
+    for (char c : v) {
+      switch (c) {
+        case '<':
+          out.append("&lt;");
+          break;
+        case '>':
+          out.append("&gt;");
+          break;
+        case '&':
+          out.append("&amp;");
+          break;
+        case '"':
+          out.append("&quot;");
+          break;
+        case '\'':
+          out.append("&apos;");
+          break;
+        default:
+          /*
+            Control characters other than tab and new lines are not allowed in XML 1.0.
+          */
+          if (static_cast<unsigned char>(c) < 0x20 && c != '\t' && c != '\n' && c != '\r') {
+            out.push_back('?');
+          } else {
+            out.push_back(c);
+          }
+      }
+    }
+    return out;
+  }
+
+  double to_seconds(std::chrono::nanoseconds dur) {
+    return static_cast<double>(dur.count()) / 1e9;
+  }
+
+  /*
+    Writes one JSON object per line : a "start" record, a "test" or "skipped" record per test in
+    suite order and a closing "summary" record.
+  */
+  export struct JsonLinesReporter : public TestListener {
+    explicit JsonLinesReporter(BufferedWriter writer) : __out{std::move(writer)} {}
+
+    void run_started(size_t test_count) override {
+      __out.print(R"({{"event":"start","tests":{}}})""\n", test_count);
+      __out.flush();
+    }
+
+    void test_finished(size_t index, std::string_view name, const TestResult &res) override {
+      auto dur = std::chrono::duration_cast<std::chrono::nanoseconds>(res.running_time());
+      __out.print(
+        R"({{"event":"test","index":{},"name":{},"status":"{}","duration_ns":{})",
+        index,
+        json_string(name),
+        res.is_ok() ? "ok" : "error",
+        dur.count()
+      );
+      if (auto err = res.get_error()) {
+        __out.print(
+          R"(,"error":{{"name":{},"message":{}}})",
+          json_string(err->name),
+          json_string(err->message)
+        );
+      }
+      if (const auto &bench = res.benchmark()) {
+        __out.print(
+          R"(,"benchmark":{{"iterations":{},"samples":{},"min_ns":{},"median_ns":{},)"
+          R"("mean_ns":{},"mad_ns":{}}})",
+          bench->iterations,
+          bench->samples.size(),
+          json_number(bench->min),
+          json_number(bench->median),
+          json_number(bench->mean),
+          json_number(bench->mad)
+        );
+      }
+      if (const auto &usage = res.resources()) {
+        __out.print(
+          R"(,"resources":{{"user_time_us":{},"system_time_us":{},"max_rss_delta_kb":{},)"
+          R"("minor_faults":{},"major_faults":{},"voluntary_switches":{},)"
+          R"("involuntary_switches":{}}})",
+          usage->user_time.count(),
+          usage->system_time.count(),
+          usage->max_rss_delta_kb,
+          usage->minor_faults,
+          usage->major_faults,
+          usage->voluntary_switches,
+          usage->involuntary_switches
+        );
+      }
+      if (const auto &counters = res.counters()) {
+        __out.print(
+          R"(,"counters":{{"cycles":{},"instructions":{},"ipc":{},"branch_misses":{},)"
+          R"("l1d_read_misses":{},"llc_misses":{}}})",
+          json_number(counters->cycles),
+          json_number(counters->instructions),
+          json_number(counters->ipc()),
+          json_number(counters->branch_misses),
+          json_number(counters->l1d_read_misses),
+          json_number(counters->llc_misses)
+        );
+      }
+      if (const auto &allocs = res.allocations()) {
+        __out.print(
+          R"(,"allocations":{{"count":{},"bytes":{},"peak_live_bytes":{}}})",
+          allocs->count,
+          allocs->bytes,
+          allocs->peak_live_bytes
+        );
+      }
+      if (res.arena_high_water_mark() != 0) {
+        __out.print(R"(,"arena_high_water_mark":{})", res.arena_high_water_mark());
+      }
+      __out.write("}\n").end_record();
+    }
+
+    void test_skipped(size_t index, std::string_view name) override {
+      __out.print(R"({{"event":"skipped","index":{},"name":{}}})""\n", index, json_string(name));
+      __out.end_record();
+    }
+
+    void run_finished(const RunSummary &summary) override {
+      __out.print(
+        R"({{"event":"summary","passed":{},"failed":{},"skipped":{},"duration_ns":{})",
+        summary.passed,
+        summary.failed,
+        summary.skipped,
+        summary.duration.count()
+      );
+      if (summary.shard) {
+        __out.print(
+          R"(,"shard":{{"index":{},"count":{}}})", summary.shard->index, summary.shard->count
+        );
+      }
+      __out.print(R"(,"seed":{}}})""\n", summary.seed);
+      __out.flush();
+    }
+
+  private:
+    BufferedWriter __out;
+  };
+
+  /*
+    Writes a JUnit XML document with a single testsuite. Assertion failures and performance
+    regressions are reported as <failure>, other exceptions and crashes as <error>. When writing
+    to a file, the closing tags are kept at the end of the file after every flush and the counts
+    are filled into the testsuite tag at the end of the run, so that an interrupted run still
+    leaves a well formed document.
+  */
+  export struct JUnitReporter : public TestListener {
+    JUnitReporter(BufferedWriter writer, std::string suite_name) :
+      __out{std::move(writer)}, __suite{xml_escape(suite_name)} {}
+
+    void run_started(size_t test_count) override {
+      __out.write("<?xml version=\"1.0\" encoding=\"UTF-8\"?>\n<testsuites>\n");
+      __header_offset = __out.size();
+      __out.write(suite_tag(std::string(header_reserve, ' '))).write("\n");
+      __out.set_trailer("  </testsuite>\n</testsuites>\n");
+      __out.flush();
+    }
+
+    void test_finished(size_t index, std::string_view name, const TestResult &res) override {
+      auto dur = std::chrono::duration_cast<std::chrono::nanoseconds>(res.running_time());
+      __out.print(
+        R"(    <testcase name="{}" classname="{}" time="{:.6f}")",
+        xml_escape(name),
+        __suite,
+        to_seconds(dur)
+      );
+      auto err = res.get_error();
+      if (!err) {
+        __out.write("/>\n").end_record();
+        return;
+      }
+      bool failure = err->name == get_type_name<FailAssertion>() ||
+        err->name == performance_regression;
+      __failures += failure ? 1 : 0;
+      __errors += failure ? 0 : 1;
+      __out.print(
+        ">\n      <{} type=\"{}\" message=\"{}\">{}</{}>\n    </testcase>\n",
+        failure ? "failure" : "error",
+        xml_escape(err->name),
+        xml_escape(err->message),
+        xml_escape(err->message),
+        failure ? "failure" : "error"
+      );
+      __out.end_record();
+    }
+
+    void test_skipped(size_t index, std::string_view name) override {
+      __out.print(
+        "    <testcase name=\"{}\" classname=\"{}\">\n      <skipped/>\n    </testcase>\n",
+        xml_escape(name),
+        __suite
+      );
+      __out.end_record();
+    }
+
+    void run_finished(const RunSummary &summary) override {
+      __out.flush();
+      auto counts = std::format(
+        R"( tests="{}" failures="{}" errors="{}" skipped="{}" time="{:.6f}")",
+        summary.passed + summary.failed + summary.skipped,
+        __failures,
+        __errors,
+        summary.skipped,
+        to_seconds(summary.duration)
+      );
+      if (counts.size() <= header_reserve) {
+        counts.resize(header_reserve, ' ');
+        __out.write_at(__header_offset, suite_tag(counts));
+      }
+    }
+
+  private:
+    static constexpr size_t header_reserve = 128;
+    BufferedWriter __out;
+    std::string __suite;
+    size_t __header_offset = 0;
+    size_t __failures = 0;
+    size_t __errors = 0;
+
+    std::string suite_tag(std::string_view attributes) const {
+      return std::format(R"(  <testsuite name="{}"{}>)", __suite, attributes);
+    }
+  };
+}
@@ -0,0 +1,69 @@
+module;
+#include <sys/resource.h>
+#include <sys/time.h>
+#include <chrono>
+#include <cstdint>
+export module jowi.test_lib:resources;
+
+namespace jowi::test_lib {
+  /*
+    Resources consumed while running a single test. Times, faults and context switches are
+    counted for the thread running the test where the platform supports it (Linux), otherwise
+    for the whole process. The peak resident set size is always process wide, max_rss_delta is
+    therefore how much the test raised the peak.
+  */
+  export struct ResourceUsage {
+    std::chrono::microseconds user_time;
+    std::chrono::microseconds system_time;
+    int64_t max_rss_delta_kb;
+    int64_t minor_faults;
+    int64_t major_faults;
+    int64_t voluntary_switches;
+    int64_t involuntary_switches;
+  };
+
+  std::chrono::microseconds to_microseconds(const timeval &t) {
+    return std::chrono::seconds{t.tv_sec} + std::chrono::microseconds{t.tv_usec};
+  }
+
+  int64_t max_rss_kb(const rusage &usage) {
+#if defined(__APPLE__)
+    return static_cast<int64_t>(usage.ru_maxrss) / 1024;
+#else
+    return static_cast<int64_t>(usage.ru_maxrss);
+#endif
+  }
+
+  rusage current_usage() {
+    rusage usage{};
+#if defined(RUSAGE_THREAD)
+    getrusage(RUSAGE_THREAD, &usage);
+#else
+    getrusage(RUSAGE_SELF, &usage);
+#endif
+    return usage;
+  }
+
+  /*
+    Measures the resources used by the calling thread from construction until stop() is called.
+  */
+  export struct ResourceMeter {
+    ResourceMeter() : __beg{current_usage()} {}
+
+    ResourceUsage stop() const {
+      auto end = current_usage();
+      return ResourceUsage{
+        .user_time = to_microseconds(end.ru_utime) - to_microseconds(__beg.ru_utime),
+        .system_time = to_microseconds(end.ru_stime) - to_microseconds(__beg.ru_stime),
+        .max_rss_delta_kb = max_rss_kb(end) - max_rss_kb(__beg),
+        .minor_faults = end.ru_minflt - __beg.ru_minflt,
+        .major_faults = end.ru_majflt - __beg.ru_majflt,
+        .voluntary_switches = end.ru_nvcsw - __beg.ru_nvcsw,
+        .involuntary_switches = end.ru_nivcsw - __beg.ru_nivcsw
+      };
+    }
+
+  private:
+    rusage __beg;
+  };
+}
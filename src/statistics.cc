@@ -0,0 +1,106 @@
+module;
+#include <algorithm>
+#include <cmath>
+#include <numeric>
+#include <span>
+#include <utility>
+#include <vector>
+export module jowi.test_lib:statistics;
+
+namespace jowi::test_lib {
+  /*
+    Returns the median of a list of values. The list is taken by value because it is partially
+    sorted in the process.
+  */
+  double median(std::vector<double> values) {
+    if (values.empty()) {
+      return 0;
+    }
+    auto mid = values.begin() + values.size() / 2;
+    std::ranges::nth_element(values, mid);
+    if (values.size() % 2 == 1) {
+      return *mid;
+    }
+    return (*mid + *std::max_element(values.begin(), mid)) / 2;
+  }
+
+  /*
+    One sided Mann-Whitney U test. Returns the p-value of the hypothesis that values drawn from
+    rhs tend to be larger than values drawn from lhs, using the normal approximation with tie and
+    continuity correction.
+  */
+  double mann_whitney_greater(std::span<const double> lhs, std::span<const double> rhs) {
+    double n1 = static_cast<double>(lhs.size());
+    double n2 = static_cast<double>(rhs.size());
+    if (lhs.empty() || rhs.empty()) {
+      return 1;
+    }
+    std::vector<std::pair<double, bool>> values;
+    values.reserve(lhs.size() + rhs.size());
+    for (double v : lhs) {
+      values.emplace_back(v, false);
+    }
+    for (double v : rhs) {
+      values.emplace_back(v, true);
+    }
+    std::ranges::sort(values);
+    double rhs_rank_sum = 0;
+    double tie_term = 0;
+    for (size_t beg = 0; beg < values.size();) {
+      size_t end = beg;
+      while (end < values.size() && values[end].first == values[beg].first) {
+        end += 1;
+      }
+      double rank = static_cast<double>(beg + end + 1) / 2;
+      double ties = static_cast<double>(end - beg);
+      tie_term += ties * ties * ties - ties;
+      for (size_t i = beg; i < end; i += 1) {
+        rhs_rank_sum += values[i].second ? rank : 0;
+      }
+      beg = end;
+    }
+    double n = n1 + n2;
+    double u = rhs_rank_sum - n2 * (n2 + 1) / 2;
+    double variance = n1 * n2 / 12 * ((n + 1) - tie_term / (n * (n - 1)));
+    if (variance <= 0) {
+      return 1;
+    }
+    double z = (u - n1 * n2 / 2 - 0.5) / std::sqrt(variance);
+    return 0.5 * std::erfc(z / std::sqrt(2.0));
+  }
+
+  /*
+    Timing distribution of a benchmark. Every sample is the time taken by a single iteration in
+    nanoseconds, averaged over iterations runs.
+  */
+  export struct BenchmarkStats {
+    size_t iterations;
+    std::vector<double> samples;
+    double min;
+    double median;
+    double mean;
+    /*
+      Median absolute deviation from the median, a spread estimate that is not sensitive to
+      outliers such as a sample interrupted by the scheduler.
+    */
+    double mad;
+
+    static BenchmarkStats from_samples(size_t iterations, std::vector<double> samples) {
+      BenchmarkStats stats{iterations, std::move(samples), 0, 0, 0, 0};
+      if (stats.samples.empty()) {
+        return stats;
+      }
+      stats.min = std::ranges::min(stats.samples);
+      stats.median = test_lib::median(stats.samples);
+      stats.mean = std::accumulate(stats.samples.begin(), stats.samples.end(), 0.0) /
+        static_cast<double>(stats.samples.size());
+      std::vector<double> deviations;
+      deviations.reserve(stats.samples.size());
+      for (double v : stats.samples) {
+        deviations.push_back(std::abs(v - stats.median));
+      }
+      stats.mad = test_lib::median(std::move(deviations));
+      return stats;
+    }
+  };
+}
@@ -0,0 +1,150 @@
+module;
+#include <algorithm>
+#include <bit>
+#include <cstddef>
+#include <memory>
+#include <memory_resource>
+#include <optional>
+export module jowi.test_lib:arena;
+
+namespace jowi::test_lib {
+  /*
+    A monotonic arena handed to tests as a std::pmr::memory_resource. Deallocation is a no-op,
+    everything is released at once by reset(). The arena keeps its buffer across resets and grows
+    it to the largest amount of memory used so far, so that a test reusing the arena does not go
+    back to the upstream allocator once the arena is warm.
+  */
+  export struct TestArena final : public std::pmr::memory_resource {
+    /*
+      No memory is taken until the first allocation, so threads that never use their arena do not
+      pay for it.
+    */
+    explicit TestArena(size_t capacity = 64 * 1024) : __capacity{std::max<size_t>(capacity, 1)} {
+      __res.emplace(__capacity, std::pmr::new_delete_resource());
+    }
+    TestArena(const TestArena &) = delete;
+    TestArena &operator=(const TestArena &) = delete;
+
+    /*
+      Bytes handed out since the last reset.
+    */
+    size_t used() const {
+      return __used;
+    }
+
+    /*
+      Size of the buffer kept across resets.
+    */
+    size_t capacity() const {
+      return __capacity;
+    }
+
+    /*
+      The most bytes handed out between two resets since the last call to
+      take_high_water_mark().
+    */
+    size_t high_water_mark() const {
+      return std::max(__high_water, __used);
+    }
+
+    size_t take_high_water_mark() {
+      auto mark = high_water_mark();
+      __high_water = __used;
+      return mark;
+    }
+
+    /*
+      Releases every allocation. Every pointer obtained from the arena is invalidated.
+    */
+    void reset() {
+      __high_water = high_water_mark();
+      if (__used == 0) {
+        return;
+      }
+      __res.reset();
+      if (!__buf || __used > __capacity) {
+        __capacity = std::bit_ceil(std::max(__used, __capacity));
+        __buf = std::make_unique_for_overwrite<std::byte[]>(__capacity);
+      }
+      __res.emplace(__buf.get(), __capacity, std::pmr::new_delete_resource());
+      __used = 0;
+    }
+
+  private:
+    size_t __capacity;
+    std::unique_ptr<std::byte[]> __buf;
+    std::optional<std::pmr::monotonic_buffer_resource> __res;
+    size_t __used = 0;
+    size_t __high_water = 0;
+
+    void *do_allocate(size_t bytes, size_t alignment) override {
+      void *ptr = __res->allocate(bytes, alignment);
+      __used += bytes;
+      return ptr;
+    }
+    void do_deallocate(void *, size_t, size_t) override {}
+    bool do_is_equal(const std::pmr::memory_resource &other) const noexcept override {
+      return this == &other;
+    }
+  };
+
+  /*
+    The arena of the calling thread. Every worker thread has its own arena, which the runner
+    resets after every test, see ArenaScope. Memory taken from it must not outlive the test.
+  */
+  export TestArena &test_arena() {
+    thread_local TestArena arena{};
+    return arena;
+  }
+
+  size_t &arena_depth() {
+    thread_local size_t depth = 0;
+    return depth;
+  }
+
+  /*
+    A run using the arena of the calling thread : a test, a benchmark or a property case. Runs
+    nest when a test runs another test or the cases of a property on its own thread, only the
+    outermost run resets the arena so that the memory of the enclosing test stays valid.
+  */
+  class ArenaScope {
+    size_t __mark;
+    bool __outermost;
+
+  public:
+    ArenaScope() : __mark{test_arena().used()}, __outermost{arena_depth() == 0} {
+      arena_depth() += 1;
+    }
+    ArenaScope(const ArenaScope &) = delete;
+    ArenaScope &operator=(const ArenaScope &) = delete;
+    ~ArenaScope() {
+      arena_depth() -= 1;
+    }
+
+    bool outermost() const {
+      return __outermost;
+    }
+
+    /*
+      Releases the memory taken during the run, e.g. between the batches of a benchmark, unless
+      the run is nested.
+    */
+    void reset() {
+      if (__outermost) {
+        test_arena().reset();
+      }
+    }
+
+    /*
+      Ends the run, returns the most bytes it took from the arena.
+    */
+    size_t release() {
+      auto &arena = test_arena();
+      if (!__outermost) {
+        return arena.used() - __mark;
+      }
+      arena.reset();
+      return arena.take_high_water_mark();
+    }
+  };
+}
@@ -1,8 +1,16 @@
 module;
 #include <array>
 #include <chrono>
+#include <concepts>
 #include <functional>
+#include <memory>
+#include <type_traits>
+#include <utility>
+#include <vector>
 export module jowi.test_lib:TestContext;
+import :arena;
+import :TestEntry;
+import :EventBus;
 import :TestSuite;
 
 namespace jowi::test_lib {
@@ -42,6 +50,31 @@ namespace jowi::test_lib {
         return std::format("{:.2f} s", converted_dur / 1e9);
       }
     }
+    /*
+      The arena of the calling thread, see test_arena().
+    */
+    TestArena &arena() const {
+      return test_arena();
+    }
+    /*
+      Registers a listener receiving the events of every run next to the reporter selected on the
+      command line, e.g. to store results. Call it from JOWI_SETUP.
+    */
+    template <std::derived_from<TestListener> L> TestContext &add_listener(L &&listener) {
+      __listeners.emplace_back(std::make_unique<std::decay_t<L>>(std::forward<L>(listener)));
+      return *this;
+    }
+    TestContext &add_listener(std::unique_ptr<TestListener> listener) {
+      __listeners.emplace_back(std::move(listener));
+      return *this;
+    }
+    std::vector<TestListener *> listeners() const {
+      std::vector<TestListener *> listeners;
+      for (const auto &l : __listeners) {
+        listeners.push_back(l.get());
+      }
+      return listeners;
+    }
     void setup(int argc, const char **argv) const {
       __setup(argc, argv);
     }
@@ -52,6 +85,7 @@ namespace jowi::test_lib {
   private:
     std::function<void(int, const char **)> __setup;
     std::function<void()> __teardown;
+    std::vector<std::unique_ptr<TestListener>> __listeners;
   };
 
   auto ctx = TestContext{};
@@ -59,4 +93,15 @@ namespace jowi::test_lib {
   export TestContext &get_test_context() {
     return ctx;
   }
+
+  /*
+    Adds a constinit test entry to the global suite during static initialization, used by
+    JOWI_ADD_TEST, JOWI_ADD_BENCHMARK and JOWI_ADD_FUZZ. Registering only stores a pointer to the
+    entry.
+  */
+  export struct StaticTestRegistration {
+    StaticTestRegistration(const GenericTestEntry &entry) {
+      get_test_context().tests.add_static_test(entry);
+    }
+  };
 }
\ No newline at end of file
@@ -1,13 +1,29 @@
 module;
 #include <chrono>
 #include <concepts>
+#include <cstddef>
+#include <exception>
 #include <expected>
+#include <format>
+#include <functional>
 #include <memory>
 #include <optional>
+#include <source_location>
+#include <span>
+#include <string>
 #include <string_view>
+#include <type_traits>
+#include <utility>
 export module jowi.test_lib:TestEntry;
+import :alloc;
+import :arena;
 import :exception;
+import :expect;
+import :perf;
+import :randomizer;
 import :reflection;
+import :resources;
+import :statistics;
 
 namespace jowi::test_lib {
   /*
@@ -27,6 +43,11 @@ namespace jowi::test_lib {
       return __err;
     }
 
+    TestResult &set_error(ExceptionInfo err) {
+      __err = std::move(err);
+      return *this;
+    }
+
     bool is_ok() const {
       return !__err.has_value();
     }
@@ -34,9 +55,69 @@ namespace jowi::test_lib {
       return __err.has_value();
     }
 
+    /*
+      The timing distribution, only set for benchmarks.
+    */
+    const std::optional<BenchmarkStats> &benchmark() const {
+      return __bench;
+    }
+    TestResult &set_benchmark(BenchmarkStats stats) {
+      __bench = std::move(stats);
+      return *this;
+    }
+
+    /*
+      The resources used by the test, not set for results that did not come from a test run.
+    */
+    const std::optional<ResourceUsage> &resources() const {
+      return __resources;
+    }
+    TestResult &set_resources(ResourceUsage usage) {
+      __resources = usage;
+      return *this;
+    }
+
+    /*
+      The hardware counters of the test, only set when counters are enabled.
+    */
+    const std::optional<PerfCounters> &counters() const {
+      return __counters;
+    }
+    TestResult &set_counters(PerfCounters counters) {
+      __counters = counters;
+      return *this;
+    }
+
+    /*
+      The allocations made by the test, only set when allocation tracking is enabled.
+    */
+    const std::optional<AllocStats> &allocations() const {
+      return __allocs;
+    }
+    TestResult &set_allocations(AllocStats stats) {
+      __allocs = stats;
+      return *this;
+    }
+
+    /*
+      The most bytes the test took from its test_arena().
+    */
+    size_t arena_high_water_mark() const {
+      return __arena_bytes;
+    }
+    TestResult &set_arena_high_water_mark(size_t bytes) {
+      __arena_bytes = bytes;
+      return *this;
+    }
+
   private:
     std::chrono::system_clock::duration __runtime;
     std::optional<ExceptionInfo> __err;
+    std::optional<BenchmarkStats> __bench;
+    std::optional<ResourceUsage> __resources;
+    std::optional<PerfCounters> __counters;
+    std::optional<AllocStats> __allocs;
+    size_t __arena_bytes = 0;
   };
 
   /*
@@ -49,9 +130,132 @@ namespace jowi::test_lib {
     virtual ~GenericTestEntry() = default;
   };
 
+  template <class R> struct is_void_expected : std::false_type {};
+  template <class E> struct is_void_expected<std::expected<void, E>> : std::true_type {};
+
+  /*
+    What a test body may return to report its failure without throwing : false, an unexpected
+    error or an ExceptionInfo. Other return values are ignored.
+  */
+  export template <class R>
+  concept test_result = std::same_as<R, bool> ||
+    std::same_as<R, std::optional<ExceptionInfo>> || is_void_expected<R>::value;
+
+  /*
+    The failure reported by the value a test body returned. Exceptions returned as errors are
+    reported like thrown ones, false and other errors like a failed assertion, described like
+    assert_expected does.
+  */
+  template <test_result R> std::optional<ExceptionInfo> result_error(R res) {
+    if constexpr (std::same_as<R, bool>) {
+      if (res) {
+        return std::nullopt;
+      }
+      return ExceptionInfo{std::string{get_type_name<FailAssertion>()}, "the test returned false"};
+    } else if constexpr (std::same_as<R, std::optional<ExceptionInfo>>) {
+      return std::move(res);
+    } else {
+      using error_type = typename R::error_type;
+      if (res.has_value()) {
+        return std::nullopt;
+      } else if constexpr (std::same_as<error_type, ExceptionInfo>) {
+        return std::move(res.error());
+      } else if constexpr (is_exception<error_type>) {
+        return ExceptionInfo{res.error()};
+      } else if constexpr (std::formattable<error_type, char>) {
+        return ExceptionInfo{
+          std::string{get_type_name<FailAssertion>()}, std::format("{}", res.error())
+        };
+      } else {
+        return ExceptionInfo{
+          std::string{get_type_name<FailAssertion>()}, "the test returned an unexpected value"
+        };
+      }
+    }
+  }
+
+  /*
+    Runs a test body, returning the failure it reported as a value if it returns a test_result.
+  */
+  template <std::invocable F> std::optional<ExceptionInfo> run_body(const F &f) {
+    using result_type = std::remove_cvref_t<std::invoke_result_t<const F &>>;
+    if constexpr (test_result<result_type>) {
+      return result_error(std::invoke(f));
+    } else {
+      std::invoke(f);
+      return std::nullopt;
+    }
+  }
+
+  /*
+    Runs a test body through a plain function pointer, data is what the body needs, e.g. the
+    callable of a TestEntry. Returns the failure reported by a test_result.
+  */
+  using TestThunk = std::optional<ExceptionInfo> (*)(const void *data);
+
+  template <class F> std::optional<ExceptionInfo> invoke_thunk(const void *f) {
+    return run_body(*static_cast<const F *>(f));
+  }
+
+  /*
+    Runs a test body and takes every enabled measurement around it. The generator of the calling
+    thread is seeded with the seed of the test beforehand. A failure returned by the body is used
+    as is, without throwing, exceptions are translated by translate_exception with the given
+    translators. Failed expectations of the expect_* assertions fail the test once it returns,
+    after the thrown error if any. Resets the arena of the calling thread afterwards, unless the
+    test runs within another one. This is shared by every test, a test only instantiates the
+    thunk calling its body.
+  */
+  TestResult run_measured(
+    std::string_view name,
+    TestThunk f,
+    const void *data,
+    std::span<const ExceptionTranslator> translators = {}
+  ) {
+    auto seed = SeedScope{test_seed(name)};
+    auto expectations = ExpectScope{};
+    auto arena = ArenaScope{};
+    // The counters of the thread are in use by the enclosing test when the run is nested.
+    auto *counters =
+      perf_counters_enabled() && arena.outermost() ? &thread_perf_counters() : nullptr;
+    auto meter = ResourceMeter{};
+    auto alloc_meter = AllocMeter{};
+    std::optional<ExceptionInfo> err;
+    auto beg = std::chrono::steady_clock::now();
+    if (counters) {
+      counters->start();
+    }
+    try {
+      err = f(data);
+    } catch (...) {
+      err = translate_exception(std::current_exception(), translators);
+    }
+    auto counts = counters ? std::optional{counters->stop()} : std::nullopt;
+    auto end = std::chrono::steady_clock::now();
+    auto allocs = alloc_meter.stop();
+    auto usage = meter.stop();
+    auto dur = std::chrono::duration_cast<std::chrono::system_clock::duration>(end - beg);
+    if (auto failed = expectations.take(); failed && err) {
+      err->message += std::format("\n{}", failed->message);
+    } else if (failed) {
+      err = std::move(failed);
+    }
+    auto result = TestResult{dur, std::move(err)};
+    result.set_resources(usage);
+    if (counts) {
+      result.set_counters(counts.value());
+    }
+    if (allocation_tracking_enabled()) {
+      result.set_allocations(allocs);
+    }
+    result.set_arena_high_water_mark(arena.release());
+    return result;
+  }
+
   /*
     Creates a test configuration that will run a test based on a lambda. This includes exceptions,
-    including custom ones, that can be caught by the runner.
+    including custom ones, that can be caught by the runner. A lambda returning a test_result
+    fails the test through its return value.
   */
   export template <std::invocable F, is_exception... exceptions>
   struct TestEntry : public GenericTestEntry {
@@ -65,15 +269,7 @@ namespace jowi::test_lib {
       const ExceptionPack<exceptions...> &p = ExceptionPack<>{}
     ) : __f{f}, __name{test_name} {}
     TestResult run_test() const override {
-      auto beg = std::chrono::system_clock::now();
-      auto res =
-        ExceptionCatcher<exceptions..., FailAssertion, std::runtime_error, std::exception>::make()
-          .safely_run_invocable(__f);
-      auto end = std::chrono::system_clock::now();
-      auto dur = end - beg;
-      return res.transform_error(
-                  [&](auto &&e) { return TestResult{dur, std::move(e)}; }
-      ).error_or(TestResult{dur});
+      return run_measured(__name, &invoke_thunk<F>, &__f, exception_translators<exceptions...>);
     }
 
   private:
@@ -81,6 +277,46 @@ namespace jowi::test_lib {
     std::string __name;
   };
 
+  /*
+    A test that is registered without touching the heap. JOWI_ADD_TEST declares one as a constinit
+    variable, it only holds the name of the test, a function pointer running it and where the test
+    is defined.
+  */
+  export struct StaticTestEntry final : public GenericTestEntry {
+    using body_type = std::optional<ExceptionInfo> (*)();
+
+    constexpr StaticTestEntry(std::string_view name, body_type f, std::source_location loc) :
+      __name{name}, __f{f}, __loc{loc} {}
+
+    /*
+      Creates the entry of a default constructible test, named after its type.
+    */
+    template <std::default_initializable T>
+      requires(std::invocable<const T &>)
+    static constexpr StaticTestEntry of(
+      std::source_location loc = std::source_location::current()
+    ) {
+      return StaticTestEntry{get_type_name<T>(), []() { return run_body(T{}); }, loc};
+    }
+
+    std::string_view name() const override {
+      return __name;
+    }
+    const std::source_location &location() const {
+      return __loc;
+    }
+    TestResult run_test() const override {
+      return run_measured(
+        __name, [](const void *f) { return (*static_cast<const body_type *>(f))(); }, &__f
+      );
+    }
+
+  private:
+    std::string_view __name;
+    body_type __f;
+    std::source_location __loc;
+  };
+
   export template <std::invocable F, is_exception... exceptions>
   constexpr std::unique_ptr<GenericTestEntry> make_test_entry(
     F &&f,
@@ -0,0 +1,223 @@
+module;
+#include <cstddef>
+#include <expected>
+#include <format>
+#include <functional>
+#include <regex>
+#include <string>
+#include <string_view>
+#include <unordered_set>
+#include <vector>
+export module jowi.test_lib:TestFilter;
+import :TestSuite;
+
+namespace jowi::test_lib {
+  struct NameHash {
+    using is_transparent = void;
+    size_t operator()(std::string_view v) const {
+      return std::hash<std::string_view>{}(v);
+    }
+  };
+
+  /*
+    Finds the end of the bracket expression starting at pattern[beg] == '['. Returns npos when
+    the bracket is never closed.
+  */
+  size_t bracket_end(std::string_view pattern, size_t beg) {
+    size_t i = beg + 1;
+    if (i < pattern.size() && pattern[i] == '!') {
+      i += 1;
+    }
+    // A ']' right after the opening bracket is part of the set.
+    if (i < pattern.size() && pattern[i] == ']') {
+      i += 1;
+    }
+    for (; i < pattern.size(); i += 1) {
+      if (pattern[i] == ']') {
+        return i;
+      }
+    }
+    return std::string_view::npos;
+  }
+
+  bool bracket_matches(std::string_view set, char c) {
+    bool negate = !set.empty() && set[0] == '!';
+    if (negate) {
+      set.remove_prefix(1);
+    }
+    bool found = false;
+    for (size_t i = 0; i < set.size() && !found; i += 1) {
+      if (i + 2 < set.size() && set[i + 1] == '-') {
+        found = set[i] <= c && c <= set[i + 2];
+        i += 2;
+      } else {
+        found = set[i] == c;
+      }
+    }
+    return found != negate;
+  }
+
+  /*
+    Matches a whole name against a shell style glob : '*' matches any sequence, '?' any
+    character, '[a-z]' and '[!a-z]' a set of characters and '\' escapes the next character. The
+    last '*' seen is the only backtracking point, which keeps matching linear in practice.
+  */
+  bool glob_matches(std::string_view pattern, std::string_view name) {
+    size_t p = 0;
+    size_t n = 0;
+    size_t star_p = std::string_view::npos;
+    size_t star_n = 0;
+    while (n < name.size()) {
+      if (p < pattern.size()) {
+        char c = pattern[p];
+        if (c == '*') {
+          star_p = p;
+          star_n = n;
+          p += 1;
+          continue;
+        } else if (c == '?') {
+          p += 1;
+          n += 1;
+          continue;
+        } else if (c == '[') {
+          size_t end = bracket_end(pattern, p);
+          if (end != std::string_view::npos) {
+            if (bracket_matches(pattern.substr(p + 1, end - p - 1), name[n])) {
+              p = end + 1;
+              n += 1;
+              continue;
+            }
+          } else if (name[n] == '[') {
+            p += 1;
+            n += 1;
+            continue;
+          }
+        } else {
+          if (c == '\\' && p + 1 < pattern.size()) {
+            c = pattern[p + 1];
+            if (c == name[n]) {
+              p += 2;
+              n += 1;
+              continue;
+            }
+          } else if (c == name[n]) {
+            p += 1;
+            n += 1;
+            continue;
+          }
+        }
+      }
+      if (star_p == std::string_view::npos) {
+        return false;
+      }
+      p = star_p + 1;
+      star_n += 1;
+      n = star_n;
+    }
+    while (p < pattern.size() && pattern[p] == '*') {
+      p += 1;
+    }
+    return p == pattern.size();
+  }
+
+  /*
+    Selects tests by name. A pattern is one of :
+    - a test name, matched exactly through a hash set.
+    - a glob, any pattern containing '*', '?' or '['. A glob whose only wildcard is a trailing
+      '*', e.g. 'Suite.*', is matched as a plain prefix.
+    - a regular expression prefixed with 're:', which has to match the whole name.
+    Patterns are compiled once, a name matches the filter when it matches any of its patterns.
+  */
+  export struct TestFilter {
+    /*
+      Compiles a pattern into the filter. Fails for invalid regular expressions.
+    */
+    std::expected<void, std::string> add(std::string_view pattern) {
+      if (pattern.starts_with("re:")) {
+        try {
+          __regexes.emplace_back(
+            std::string{pattern.substr(3)}, std::regex::ECMAScript | std::regex::optimize
+          );
+        } catch (const std::regex_error &e) {
+          return std::unexpected{
+            std::format("'{}' is not a valid regex : {}", pattern, e.what())
+          };
+        }
+        return {};
+      }
+      auto meta = pattern.find_first_of("*?[\\");
+      if (meta == std::string_view::npos) {
+        __names.emplace(pattern);
+      } else if (meta == pattern.size() - 1 && pattern[meta] == '*') {
+        __prefixes.emplace_back(pattern.substr(0, meta));
+      } else {
+        __globs.push_back(Glob{std::string{pattern}, meta});
+      }
+      return {};
+    }
+
+    bool empty() const {
+      return __names.empty() && __prefixes.empty() && __globs.empty() && __regexes.empty();
+    }
+
+    /*
+      Returns whether the pattern is a test name rather than a glob or a regular expression.
+    */
+    static bool is_name(std::string_view pattern) {
+      return !pattern.starts_with("re:") &&
+        pattern.find_first_of("*?[\\") == std::string_view::npos;
+    }
+
+    bool matches(std::string_view name) const {
+      if (__names.contains(name)) {
+        return true;
+      }
+      for (const auto &prefix : __prefixes) {
+        if (name.starts_with(prefix)) {
+          return true;
+        }
+      }
+      for (const auto &[pattern, literal] : __globs) {
+        if (
+          name.starts_with(std::string_view{pattern}.substr(0, literal)) &&
+          glob_matches(pattern, name)
+        ) {
+          return true;
+        }
+      }
+      for (const auto &re : __regexes) {
+        if (std::regex_match(name.begin(), name.end(), re)) {
+          return true;
+        }
+      }
+      return false;
+    }
+
+    /*
+      Returns the ids of the tests of the suite whose match equals include, in a single pass.
+      Selecting with include = false and an empty filter selects every test.
+    */
+    std::vector<size_t> select(const TestSuite &suite, bool include = true) const {
+      std::vector<size_t> ids;
+      size_t id = 0;
+      for (const auto &test : suite) {
+        if (matches(test->name()) == include) {
+          ids.push_back(id);
+        }
+        id += 1;
+      }
+      return ids;
+    }
+
+  private:
+    struct Glob {
+      std::string pattern;
+      // Length of the literal prefix before the first wildcard.
+      size_t literal;
+    };
+    std::unordered_set<std::string, NameHash, std::equal_to<>> __names;
+    std::vector<std::string> __prefixes;
+    std::vector<Glob> __globs;
+    std::vector<std::regex> __regexes;
+  };
+}
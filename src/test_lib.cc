@@ -2,11 +2,32 @@ module;
 #include <concepts>
 export module jowi.test_lib;
 export import :randomizer;
+export import :random_stream;
+export import :workload;
+export import :property;
+export import :fuzz;
 export import :exception;
 export import :assert;
+export import :close;
+export import :expect;
 export import :TestSuite;
+export import :TestFilter;
 export import :TestEntry;
 export import :TestContext;
+export import :TestRunner;
+export import :IsolatedRunner;
+export import :DurationStore;
+export import :TestShard;
+export import :statistics;
+export import :Benchmark;
+export import :Baseline;
+export import :resources;
+export import :perf;
+export import :alloc;
+export import :arena;
+export import :BufferedWriter;
+export import :EventBus;
+export import :Reporter;
 
 namespace jowi::test_lib {
   export enum struct SetupMode { SET_UP, TEAR_DOWN };
@@ -0,0 +1,210 @@
+module;
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <span>
+#include <thread>
+#include <vector>
+export module jowi.test_lib:TestRunner;
+import :TestEntry;
+
+namespace jowi::test_lib {
+  /*
+    A queue of test slots owned by a single worker. The owner pops from the front so that tests
+    start in the order they were scheduled, idle workers steal from the back.
+  */
+  struct WorkStealingQueue {
+    void push(size_t slot) {
+      std::lock_guard l{__mut};
+      __slots.push_back(slot);
+    }
+    std::optional<size_t> pop() {
+      std::lock_guard l{__mut};
+      if (__slots.empty()) {
+        return std::nullopt;
+      }
+      size_t slot = __slots.front();
+      __slots.pop_front();
+      return slot;
+    }
+    std::optional<size_t> steal() {
+      std::lock_guard l{__mut};
+      if (__slots.empty()) {
+        return std::nullopt;
+      }
+      size_t slot = __slots.back();
+      __slots.pop_back();
+      return slot;
+    }
+
+  private:
+    std::mutex __mut;
+    std::deque<size_t> __slots;
+  };
+
+  /*
+    Buffers results that complete out of order and hands them to the sink strictly in slot order.
+    The sink is invoked under a lock, therefore it is never called concurrently.
+  */
+  struct OrderedSink {
+    OrderedSink(size_t n, const std::function<void(size_t, TestResult &&)> &sink) :
+      __results(n), __sink{sink} {}
+
+    void deliver(size_t slot, TestResult &&res) {
+      std::lock_guard l{__mut};
+      __results[slot].emplace(std::move(res));
+      while (__next < __results.size() && __results[__next].has_value()) {
+        __sink(__next, std::move(__results[__next].value()));
+        __results[__next].reset();
+        __next += 1;
+      }
+    }
+
+    /*
+      Delivers the results held back by slots that were never run, e.g. after a cancellation.
+    */
+    void finish() {
+      std::lock_guard l{__mut};
+      for (; __next < __results.size(); __next += 1) {
+        if (__results[__next].has_value()) {
+          __sink(__next, std::move(__results[__next].value()));
+          __results[__next].reset();
+        }
+      }
+    }
+
+  private:
+    std::mutex __mut;
+    std::vector<std::optional<TestResult>> __results;
+    size_t __next = 0;
+    const std::function<void(size_t, TestResult &&)> &__sink;
+  };
+
+  /*
+    Returns the order in which slots are started, defaulting to slot order.
+  */
+  std::vector<size_t> schedule_order(size_t n, std::span<const size_t> order) {
+    if (order.size() == n) {
+      return std::vector<size_t>{order.begin(), order.end()};
+    }
+    std::vector<size_t> slots;
+    slots.reserve(n);
+    for (size_t slot = 0; slot < n; slot += 1) {
+      slots.push_back(slot);
+    }
+    return slots;
+  }
+
+  /*
+    Runs a list of tests on a pool of worker threads. Each worker owns a work stealing queue, the
+    slots are distributed in a round robin fashion and a worker that runs out of tests steals from
+    the back of the other queues.
+  */
+  export struct TestRunner {
+    using sink_type = std::function<void(size_t, TestResult &&)>;
+    using start_type = std::function<void(size_t)>;
+    using check_type = std::function<void(size_t, TestResult &)>;
+
+    TestRunner(size_t jobs, bool fail_fast = false) :
+      __jobs{std::max<size_t>(jobs, 1)}, __fail_fast{fail_fast} {}
+
+    size_t jobs() const {
+      return __jobs;
+    }
+
+    /*
+      Runs every entry and calls sink(slot, result) for each of them, where slot is the position
+      of the entry in entries. Results are always delivered in slot order. order, when given,
+      contains every slot in the order they should be started. With fail fast, the first failing
+      test cancels every test that has not started yet, those slots are never delivered.
+      started, when given, is called with the slot of every test right before it starts, from the
+      thread running it. check, when given, is called with the slot and the result of every test
+      once it finished, from the thread running it, and may fail the result. It runs before the
+      fail fast decision, a test failed by check cancels the run like any other failure.
+    */
+    void run(
+      std::span<const GenericTestEntry *const> entries,
+      const sink_type &sink,
+      std::span<const size_t> order = {},
+      const start_type &started = {},
+      const check_type &check = {}
+    ) const {
+      auto slots = schedule_order(entries.size(), order);
+      size_t workers = std::min(__jobs, entries.size());
+      OrderedSink ordered{entries.size(), sink};
+      if (workers <= 1) {
+        for (size_t slot : slots) {
+          if (started) {
+            started(slot);
+          }
+          auto res = entries[slot]->run_test();
+          if (check) {
+            check(slot, res);
+          }
+          bool failed = res.is_error();
+          ordered.deliver(slot, std::move(res));
+          if (failed && __fail_fast) {
+            break;
+          }
+        }
+        ordered.finish();
+        return;
+      }
+      auto queues = std::make_unique<WorkStealingQueue[]>(workers);
+      for (size_t i = 0; i < slots.size(); i += 1) {
+        queues[i % workers].push(slots[i]);
+      }
+      std::atomic<bool> cancelled = false;
+      std::vector<std::jthread> threads;
+      threads.reserve(workers);
+      for (size_t w = 0; w < workers; w += 1) {
+        threads.emplace_back([&, w]() {
+          while (!cancelled.load(std::memory_order_relaxed)) {
+            auto slot = next_slot(std::span{queues.get(), workers}, w);
+            if (!slot) {
+              break;
+            }
+            if (started) {
+              started(slot.value());
+            }
+            auto res = entries[slot.value()]->run_test();
+            if (check) {
+              check(slot.value(), res);
+            }
+            if (res.is_error() && __fail_fast) {
+              cancelled.store(true, std::memory_order_relaxed);
+            }
+            ordered.deliver(slot.value(), std::move(res));
+          }
+        });
+      }
+      threads.clear();
+      ordered.finish();
+    }
+
+  private:
+    size_t __jobs;
+    bool __fail_fast;
+
+    /*
+      No new work is added once the workers are started, so when every queue is empty the worker
+      can stop.
+    */
+    static std::optional<size_t> next_slot(std::span<WorkStealingQueue> queues, size_t w) {
+      if (auto slot = queues[w].pop()) {
+        return slot;
+      }
+      for (size_t i = 1; i < queues.size(); i += 1) {
+        if (auto slot = queues[(w + i) % queues.size()].steal()) {
+          return slot;
+        }
+      }
+      return std::nullopt;
+    }
+  };
+}
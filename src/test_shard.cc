@@ -0,0 +1,97 @@
+module;
+#include <algorithm>
+#include <charconv>
+#include <chrono>
+#include <numeric>
+#include <optional>
+#include <span>
+#include <string_view>
+#include <vector>
+export module jowi.test_lib:TestShard;
+import :DurationStore;
+
+namespace jowi::test_lib {
+  /*
+    A deterministic partition of a list of tests into count shards. Every shard computes the same
+    partition from the same list of tests, so running all the shards runs every test exactly once.
+  */
+  export struct TestShard {
+    size_t index;
+    size_t count;
+
+    /*
+      Parses 'INDEX/COUNT' where INDEX is zero based and less than COUNT.
+    */
+    static std::optional<TestShard> parse(std::string_view v) {
+      auto sep = v.find('/');
+      if (sep == std::string_view::npos) {
+        return std::nullopt;
+      }
+      TestShard shard{0, 0};
+      auto idx = v.substr(0, sep);
+      auto cnt = v.substr(sep + 1);
+      auto [idx_ptr, idx_ec] = std::from_chars(idx.data(), idx.data() + idx.size(), shard.index);
+      auto [cnt_ptr, cnt_ec] = std::from_chars(cnt.data(), cnt.data() + cnt.size(), shard.count);
+      if (idx_ec != std::errc{} || cnt_ec != std::errc{} || idx_ptr != idx.data() + idx.size() ||
+          cnt_ptr != cnt.data() + cnt.size() || shard.count == 0 || shard.index >= shard.count) {
+        return std::nullopt;
+      }
+      return shard;
+    }
+
+    /*
+      Returns the positions in names that belong to this shard. Without recorded durations the
+      tests are dealt in a round robin fashion. With durations, the tests are sorted longest first
+      and each is given to the least loaded shard, tests without a record are assumed to take the
+      median of the recorded durations.
+    */
+    std::vector<size_t> select(
+      std::span<const std::string_view> names, const DurationStore &durations = DurationStore{}
+    ) const {
+      std::vector<size_t> selected;
+      if (durations.empty()) {
+        for (size_t i = index; i < names.size(); i += count) {
+          selected.push_back(i);
+        }
+        return selected;
+      }
+      std::vector<int64_t> expected(names.size(), -1);
+      std::vector<int64_t> known;
+      for (size_t i = 0; i < names.size(); i += 1) {
+        if (auto dur = durations.get(names[i])) {
+          expected[i] = dur->count();
+          known.push_back(dur->count());
+        }
+      }
+      int64_t fallback = 1;
+      if (!known.empty()) {
+        auto mid = known.begin() + known.size() / 2;
+        std::ranges::nth_element(known, mid);
+        fallback = std::max<int64_t>(*mid, 1);
+      }
+      std::ranges::replace(expected, int64_t{-1}, fallback);
+
+      std::vector<size_t> order(names.size());
+      std::iota(order.begin(), order.end(), 0);
+      std::ranges::sort(order, [&](size_t l, size_t r) {
+        if (expected[l] != expected[r]) {
+          return expected[l] > expected[r];
+        }
+        if (names[l] != names[r]) {
+          return names[l] < names[r];
+        }
+        return l < r;
+      });
+      std::vector<int64_t> load(count, 0);
+      for (size_t i : order) {
+        size_t target = static_cast<size_t>(std::ranges::min_element(load) - load.begin());
+        load[target] += expected[i];
+        if (target == index) {
+          selected.push_back(i);
+        }
+      }
+      std::ranges::sort(selected);
+      return selected;
+    }
+  };
+}
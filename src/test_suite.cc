@@ -1,18 +1,102 @@
 module;
 #include <algorithm>
+#include <bit>
 #include <concepts>
 #include <functional>
 #include <memory>
+#include <mutex>
 #include <optional>
+#include <span>
+#include <string_view>
+#include <utility>
 #include <vector>
 export module jowi.test_lib:TestSuite;
+import :Benchmark;
 import :TestEntry;
 import :reflection;
 
 namespace jowi::test_lib {
+  /*
+    Open addressing hash table from test names to ids. Slots only hold ids, the names are read
+    from the entries, so the whole index is a single allocation. It is only built on the first
+    lookup, sized for every test registered by then, registering a test costs nothing.
+    When names are repeated the first test keeps the name.
+  */
+  struct NameIndex {
+    /*
+      Indexes the tests added since the last update.
+    */
+    void update(std::span<const GenericTestEntry *const> tests) {
+      if (__indexed == tests.size()) {
+        return;
+      }
+      if (tests.size() * 2 > __slots.size()) {
+        __slots.assign(std::max<size_t>(std::bit_ceil(tests.size() * 2), 64), empty);
+        __indexed = 0;
+      }
+      for (; __indexed < tests.size(); __indexed += 1) {
+        place(tests, __indexed);
+      }
+    }
+
+    std::optional<size_t> find(
+      std::span<const GenericTestEntry *const> tests, std::string_view name
+    ) const {
+      if (__slots.empty()) {
+        return std::nullopt;
+      }
+      for (size_t slot = first_slot(name);; slot = (slot + 1) & (__slots.size() - 1)) {
+        if (__slots[slot] == empty) {
+          return std::nullopt;
+        } else if (tests[__slots[slot]]->name() == name) {
+          return __slots[slot];
+        }
+      }
+    }
+
+  private:
+    static constexpr size_t empty = static_cast<size_t>(-1);
+    std::vector<size_t> __slots;
+    size_t __indexed = 0;
+
+    size_t first_slot(std::string_view name) const {
+      return std::hash<std::string_view>{}(name) & (__slots.size() - 1);
+    }
+
+    void place(std::span<const GenericTestEntry *const> tests, size_t id) {
+      auto name = tests[id]->name();
+      size_t slot = first_slot(name);
+      for (; __slots[slot] != empty; slot = (slot + 1) & (__slots.size() - 1)) {
+        if (tests[__slots[slot]]->name() == name) {
+          return;
+        }
+      }
+      __slots[slot] = id;
+    }
+  };
+
   export struct TestSuite {
   private:
-    std::vector<std::unique_ptr<GenericTestEntry>> __tests;
+    /*
+      Every test in registration order. Tests added through JOWI_ADD_TEST are constinit
+      StaticTestEntry variables, only the other tests are owned by the suite.
+    */
+    std::vector<const GenericTestEntry *> __tests;
+    std::vector<std::unique_ptr<GenericTestEntry>> __owned;
+    /*
+      Updated by find, which tests may call concurrently.
+    */
+    mutable std::mutex __index_mut;
+    mutable NameIndex __index;
+
+    TestSuite &add_entry(const GenericTestEntry &entry) {
+      __tests.push_back(&entry);
+      return *this;
+    }
+    TestSuite &add_entry(std::unique_ptr<GenericTestEntry> entry) {
+      __owned.emplace_back(std::move(entry));
+      return add_entry(*__owned.back());
+    }
 
   public:
     TestSuite() {}
@@ -22,8 +106,25 @@ namespace jowi::test_lib {
       std::string_view test_name = get_type_name<F>(),
       ExceptionPack<exceptions...> p = ExceptionPack<>{}
     ) {
-      __tests.emplace_back(make_test_entry(std::forward<F>(f), test_name, p));
-      return *this;
+      return add_entry(make_test_entry(std::forward<F>(f), test_name, p));
+    }
+    template <std::invocable F>
+    TestSuite &add_benchmark(
+      F &&f,
+      std::string_view test_name = get_type_name<F>(),
+      BenchmarkConfig config = BenchmarkConfig{}
+    ) {
+      return add_entry(
+        std::make_unique<BenchmarkEntry<F>>(std::forward<F>(f), test_name, config)
+      );
+    }
+
+    /*
+      Adds a test that outlives the suite without copying it, e.g. a StaticTestEntry or a
+      FuzzEntry.
+    */
+    TestSuite &add_static_test(const GenericTestEntry &entry) {
+      return add_entry(entry);
     }
 
     std::optional<std::reference_wrapper<const GenericTestEntry>> get(size_t id) const {
@@ -36,12 +137,16 @@ namespace jowi::test_lib {
     std::optional<std::reference_wrapper<const GenericTestEntry>> get(
       std::string_view name
     ) const {
-      auto it =
-        std::ranges::find_if(__tests, [&](const auto &test) { return test->name() == name; });
-      if (it != __tests.end()) {
-        return std::cref(**it);
-      }
-      return std::nullopt;
+      return find(name).and_then([&](size_t id) { return get(id); });
+    }
+
+    /*
+      Returns the id of the test with the given name.
+    */
+    std::optional<size_t> find(std::string_view name) const {
+      std::lock_guard l{__index_mut};
+      __index.update(__tests);
+      return __index.find(__tests, name);
     }
 
     auto begin() const {
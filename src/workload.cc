@@ -0,0 +1,435 @@
+module;
+#include <algorithm>
+#include <bit>
+#include <cmath>
+#include <concepts>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <iterator>
+#include <limits>
+#include <numbers>
+#include <numeric>
+#include <optional>
+#include <ranges>
+#include <span>
+#include <type_traits>
+#include <utility>
+#include <vector>
+export module jowi.test_lib:workload;
+import :randomizer;
+import :random_stream;
+
+namespace jowi::test_lib {
+  /*
+    A real uniform in [0, 1) from 53 random bits.
+  */
+  double unit_real(const Generator &gen) {
+    return static_cast<double>(gen.gen() >> 11) * 0x1p-53;
+  }
+
+  /*
+    A real uniform in (0, 1], safe to take the logarithm of.
+  */
+  double open_unit_real(const Generator &gen) {
+    return 1.0 - unit_real(gen);
+  }
+
+  /*
+    An integer uniform in [0, n), n > 0. The bias is at most n / 2^64.
+  */
+  uint64_t bounded(uint64_t n, const Generator &gen) {
+    return mul_high(gen.gen(), n);
+  }
+
+  /*
+    Zipf distributed ranks in [0, n) : rank k is drawn with a probability proportional to
+    1 / (k + 1)^s, rank 0 being the most frequent. Uses rejection-inversion (Hormann and
+    Derflinger), the setup only computes a few constants and a draw takes a couple of uniforms on
+    average, whatever n is. Requires n >= 1 and s > 0.
+  */
+  export struct ZipfDistribution {
+    using result_type = uint64_t;
+
+    ZipfDistribution(uint64_t n, double s) :
+      __n{static_cast<double>(n)}, __s{s}, __h_x1{h_integral(1.5) - 1.0},
+      __h_n{h_integral(__n + 0.5)}, __cut{2.0 - h_integral_inverse(h_integral(2.5) - h(2.0))} {}
+
+    uint64_t operator()(const Generator &gen = thread_generator()) const {
+      while (true) {
+        double u = __h_n + unit_real(gen) * (__h_x1 - __h_n);
+        double x = h_integral_inverse(u);
+        double k = std::clamp(std::floor(x + 0.5), 1.0, __n);
+        if (k - x <= __cut || u >= h_integral(k + 0.5) - h(k)) {
+          return static_cast<uint64_t>(k) - 1;
+        }
+      }
+    }
+
+  private:
+    double __n;
+    double __s;
+    double __h_x1;
+    double __h_n;
+    double __cut;
+
+    // log1p(x) / x, accurate around 0.
+    static double helper_1(double x) {
+      return std::abs(x) > 1e-8 ? std::log1p(x) / x
+                                : 1.0 - x * (0.5 - x * (1.0 / 3.0 - 0.25 * x));
+    }
+    // expm1(x) / x, accurate around 0.
+    static double helper_2(double x) {
+      return std::abs(x) > 1e-8 ? std::expm1(x) / x
+                                : 1.0 + x * 0.5 * (1.0 + x * (1.0 / 3.0) * (1.0 + 0.25 * x));
+    }
+    double h(double x) const {
+      return std::exp(-__s * std::log(x));
+    }
+    double h_integral(double x) const {
+      double log_x = std::log(x);
+      return helper_2((1.0 - __s) * log_x) * log_x;
+    }
+    double h_integral_inverse(double x) const {
+      double t = std::max(x * (1.0 - __s), -1.0);
+      return std::exp(helper_1(t) * x);
+    }
+  };
+
+  /*
+    Normally distributed reals, by the Box-Muller transform.
+  */
+  export template <std::floating_point T = double> struct NormalDistribution {
+    using result_type = T;
+    T mean = 0;
+    T stddev = 1;
+
+    T operator()(const Generator &gen = thread_generator()) const {
+      double r = std::sqrt(-2.0 * std::log(open_unit_real(gen)));
+      double theta = 2.0 * std::numbers::pi * unit_real(gen);
+      return static_cast<T>(mean + stddev * r * std::cos(theta));
+    }
+  };
+
+  /*
+    Exponentially distributed reals with the given rate, e.g. the time between arrivals.
+  */
+  export template <std::floating_point T = double> struct ExponentialDistribution {
+    using result_type = T;
+    T rate = 1;
+
+    T operator()(const Generator &gen = thread_generator()) const {
+      return static_cast<T>(-std::log(open_unit_real(gen)) / rate);
+    }
+  };
+
+  /*
+    Pareto distributed reals, at least scale and heavy tailed for small shapes, e.g. object or
+    request sizes.
+  */
+  export template <std::floating_point T = double> struct ParetoDistribution {
+    using result_type = T;
+
+    ParetoDistribution(T scale, T shape) : __scale{scale}, __inv_shape{1 / shape} {}
+
+    T operator()(const Generator &gen = thread_generator()) const {
+      return static_cast<T>(__scale / std::pow(open_unit_real(gen), __inv_shape));
+    }
+
+  private:
+    T __scale;
+    T __inv_shape;
+  };
+
+  /*
+    Draws indices in proportion to their weight in O(1) with Vose's alias method. The setup is
+    O(n). Weights must be non negative with a positive sum.
+  */
+  export struct AliasTable {
+    using result_type = size_t;
+
+    explicit AliasTable(std::span<const double> weights) : __slots(weights.size()) {
+      size_t n = weights.size();
+      double total = std::accumulate(weights.begin(), weights.end(), 0.0);
+      std::vector<double> scaled(n);
+      std::vector<size_t> small;
+      std::vector<size_t> large;
+      for (size_t i = 0; i < n; i += 1) {
+        scaled[i] = weights[i] * static_cast<double>(n) / total;
+        (scaled[i] < 1.0 ? small : large).push_back(i);
+      }
+      while (!small.empty() && !large.empty()) {
+        size_t s = small.back();
+        size_t l = large.back();
+        small.pop_back();
+        large.pop_back();
+        __slots[s] = Slot{scaled[s], l};
+        scaled[l] = (scaled[l] + scaled[s]) - 1.0;
+        (scaled[l] < 1.0 ? small : large).push_back(l);
+      }
+      // Whatever is left has a probability of 1 up to rounding errors.
+      for (auto rest : {std::span{small}, std::span{large}}) {
+        for (size_t i : rest) {
+          __slots[i] = Slot{1.0, i};
+        }
+      }
+    }
+
+    size_t size() const {
+      return __slots.size();
+    }
+
+    /*
+      A single 64 bit draw picks both the slot and the coin.
+    */
+    size_t operator()(const Generator &gen = thread_generator()) const {
+      double u = unit_real(gen) * static_cast<double>(__slots.size());
+      size_t i = std::min(static_cast<size_t>(u), __slots.size() - 1);
+      const auto &slot = __slots[i];
+      return u - static_cast<double>(i) < slot.probability ? i : slot.alias;
+    }
+
+  private:
+    struct Slot {
+      double probability;
+      size_t alias;
+    };
+    std::vector<Slot> __slots;
+  };
+
+  /*
+    Picks elements of values with the probability of the matching weight.
+  */
+  export template <class T> struct WeightedChoice {
+    using result_type = T;
+
+    WeightedChoice(std::span<const T> values, std::span<const double> weights) :
+      __values{values}, __table{weights} {}
+
+    const T &operator()(const Generator &gen = thread_generator()) const {
+      return __values[__table(gen)];
+    }
+
+  private:
+    std::span<const T> __values;
+    AliasTable __table;
+  };
+
+  /*
+    Shuffles values uniformly (Fisher-Yates).
+  */
+  export template <class T> void random_shuffle(
+    std::span<T> values, const Generator &gen = thread_generator()
+  ) {
+    for (size_t i = values.size(); i > 1; i -= 1) {
+      std::swap(values[i - 1], values[bounded(i, gen)]);
+    }
+  }
+
+  /*
+    Swaps round(fraction * size / 2) random pairs of values, e.g. to turn a sorted sequence into a
+    partially sorted one.
+  */
+  export template <class T> void partially_shuffle(
+    std::span<T> values, double fraction, const Generator &gen = thread_generator()
+  ) {
+    if (values.size() < 2) {
+      return;
+    }
+    auto swaps = static_cast<size_t>(std::round(fraction * static_cast<double>(values.size()) / 2));
+    for (size_t i = 0; i < swaps; i += 1) {
+      std::swap(values[bounded(values.size(), gen)], values[bounded(values.size(), gen)]);
+    }
+  }
+
+  /*
+    A random permutation of [0, n).
+  */
+  export std::vector<uint64_t> random_permutation(
+    uint64_t n, const Generator &gen = thread_generator()
+  ) {
+    std::vector<uint64_t> values(n);
+    std::iota(values.begin(), values.end(), uint64_t{0});
+    random_shuffle(std::span{values}, gen);
+    return values;
+  }
+
+  /*
+    An open addressing set of integers below UINT64_MAX, for Floyd's sampling.
+  */
+  struct IntegerSet {
+    explicit IntegerSet(size_t count) :
+      __slots(std::bit_ceil(std::max<size_t>(2 * count, 16)), empty),
+      __shift{64 - std::countr_zero(__slots.size())}, __mask{__slots.size() - 1} {}
+
+    /*
+      Returns whether the value was inserted, false when it was already present.
+    */
+    bool insert(uint64_t v) {
+      for (size_t i = (v * 0x9e3779b97f4a7c15) >> __shift;; i = (i + 1) & __mask) {
+        if (__slots[i] == v) {
+          return false;
+        } else if (__slots[i] == empty) {
+          __slots[i] = v;
+          return true;
+        }
+      }
+    }
+
+  private:
+    static constexpr uint64_t empty = std::numeric_limits<uint64_t>::max();
+    std::vector<uint64_t> __slots;
+    int __shift;
+    size_t __mask;
+  };
+
+  /*
+    k distinct integers of [0, n) in increasing order, each subset being equally likely, e.g.
+    unique keys. Sparse samples use Floyd's algorithm in O(k), dense ones selection sampling
+    (Knuth's algorithm S) in O(n). Requires k <= n.
+  */
+  export std::vector<uint64_t> random_sample(
+    uint64_t n, uint64_t k, const Generator &gen = thread_generator()
+  ) {
+    std::vector<uint64_t> sample;
+    sample.reserve(k);
+    if (k > n / 8) {
+      for (uint64_t i = 0; i < n && sample.size() < k; i += 1) {
+        if (bounded(n - i, gen) < k - sample.size()) {
+          sample.push_back(i);
+        }
+      }
+      return sample;
+    }
+    auto seen = IntegerSet{k};
+    for (uint64_t j = n - k; j < n; j += 1) {
+      uint64_t t = bounded(j + 1, gen);
+      if (!seen.insert(t)) {
+        t = j;
+        seen.insert(j);
+      }
+      sample.push_back(t);
+    }
+    std::ranges::sort(sample);
+    return sample;
+  }
+
+  /*
+    A single pass view over count values, each produced by calling next() when the view is
+    advanced. Values are generated lazily, so workloads larger than memory can be streamed.
+  */
+  export template <class F>
+    requires(std::invocable<F &>)
+  struct GeneratedView : public std::ranges::view_interface<GeneratedView<F>> {
+    using value_type = std::remove_cvref_t<std::invoke_result_t<F &>>;
+
+    GeneratedView(F next, size_t count) : __next{std::move(next)}, __remaining{count} {}
+
+    struct iterator {
+      using value_type = GeneratedView::value_type;
+      using difference_type = std::ptrdiff_t;
+
+      GeneratedView *view = nullptr;
+
+      const value_type &operator*() const {
+        return view->__value.value();
+      }
+      iterator &operator++() {
+        view->advance();
+        return *this;
+      }
+      void operator++(int) {
+        view->advance();
+      }
+      friend bool operator==(const iterator &it, std::default_sentinel_t) {
+        return it.view->size() == 0;
+      }
+    };
+
+    /*
+      Can only be called once.
+    */
+    iterator begin() {
+      if (__remaining != 0) {
+        __value.emplace(std::invoke(__next));
+      }
+      return iterator{this};
+    }
+    std::default_sentinel_t end() const {
+      return std::default_sentinel;
+    }
+    size_t size() const {
+      return __remaining;
+    }
+
+  private:
+    F __next;
+    size_t __remaining;
+    std::optional<value_type> __value;
+
+    void advance() {
+      __remaining -= 1;
+      if (__remaining != 0) {
+        __value.emplace(std::invoke(__next));
+      }
+    }
+  };
+
+  template <class D> struct DrawFrom {
+    D dist;
+    const Generator *gen;
+
+    auto operator()() {
+      return dist(*gen);
+    }
+  };
+
+  /*
+    A lazy view over count values drawn from dist, e.g.
+    random_view(ZipfDistribution{1'000'000, 0.99}, 100'000'000) for skewed key accesses.
+  */
+  export template <class D>
+  GeneratedView<DrawFrom<D>> random_view(
+    D dist, size_t count, const Generator &gen = thread_generator()
+  ) {
+    return GeneratedView{DrawFrom<D>{std::move(dist), &gen}, count};
+  }
+
+  /*
+    Produces the order statistics of uniforms in [0, 1) in increasing order, one at a time :
+    the largest of m uniforms is distributed as u^(1 / m), the next ones follow by scaling.
+  */
+  template <class T> struct SortedDraw {
+    T low;
+    T high;
+    size_t remaining;
+    double top;
+    const Generator *gen;
+
+    T operator()() {
+      top *= std::pow(open_unit_real(*gen), 1.0 / static_cast<double>(remaining));
+      remaining -= 1;
+      double u = 1.0 - top;
+      if constexpr (std::integral<T>) {
+        double span = static_cast<double>(high) - static_cast<double>(low) + 1.0;
+        auto offset = static_cast<T>(std::min(std::floor(u * span), span - 1.0));
+        return static_cast<T>(low + offset);
+      } else {
+        return static_cast<T>(low + (high - low) * u);
+      }
+    }
+  };
+
+  /*
+    A lazy view over count values uniform in [low, high] for integers, [low, high) for reals, in
+    non decreasing order. Distributed as sorting count uniform values, but in O(1) memory and O(1)
+    per value.
+  */
+  export template <class T>
+    requires(std::integral<T> || std::floating_point<T>)
+  GeneratedView<SortedDraw<T>> sorted_view(
+    size_t count, T low, T high, const Generator &gen = thread_generator()
+  ) {
+    return GeneratedView{SortedDraw<T>{low, high, count, 1.0, &gen}, count};
+  }
+}
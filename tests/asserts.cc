@@ -1,9 +1,22 @@
 #include <jowi/test_lib.hpp>
 #include <algorithm>
 #include <array>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
 #include <expected>
+#include <functional>
+#include <iterator>
+#include <limits>
+#include <list>
+#include <memory>
 #include <print>
 #include <ranges>
+#include <span>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <vector>
 import jowi.test_lib;
 
 namespace test_lib = jowi::test_lib;
@@ -30,6 +43,74 @@ JOWI_ADD_TEST(test_random_float) {
   test_lib::assert_true(v >= 1.0 && v <= 10.0);
 }
 
+JOWI_ADD_TEST(test_random_is_seeded_per_test) {
+  auto gen = test_lib::Generator{42};
+  auto first = test_lib::random_string(16, test_lib::ascii_letters, gen);
+  gen.seed(42);
+  test_lib::assert_equal(test_lib::random_string(16, test_lib::ascii_letters, gen), first);
+  auto draw = []() { return test_lib::random_integer<uint64_t>(0, UINT64_MAX); };
+  auto entry = test_lib::TestEntry{[&]() { first = std::to_string(draw()); }, "seeded"};
+  entry.run_test();
+  auto drawn = first;
+  entry.run_test();
+  test_lib::assert_equal(first, drawn);
+  test_lib::thread_generator().seed(test_lib::test_seed("seeded"));
+  test_lib::assert_equal(std::to_string(draw()), drawn);
+}
+
+JOWI_ADD_TEST(test_random_stream_is_thread_count_independent) {
+  auto block = test_lib::Philox4x32::block({0, 0, 0, 0}, {0, 0});
+  test_lib::assert_equal(
+    block, std::array<uint32_t, 4>{0x6627e8d5, 0xe169c58d, 0xbc57ac4c, 0x9b00dbd8}
+  );
+  auto stream = test_lib::RandomStream{1234, 7};
+  std::vector<uint64_t> single(100003);
+  std::vector<uint64_t> split(100003);
+  auto dist = test_lib::UniformInt<uint64_t>{0, UINT64_MAX};
+  test_lib::random_fill(std::span{single}, dist, stream, 1);
+  test_lib::random_fill(std::span{split}, dist, stream, 4);
+  test_lib::assert_equal(single, split);
+  test_lib::assert_equal(single[12345], stream[12345]);
+  std::vector<std::byte> bytes(4099);
+  test_lib::random_bytes(bytes, stream);
+  test_lib::assert_equal(std::to_integer<uint32_t>(bytes[16]), stream.block(1)[0] & 0xff);
+  std::string letters(64, ' ');
+  test_lib::random_fill(std::span{letters}, test_lib::UniformChoice{test_lib::ascii_lowercase});
+  test_lib::assert_true(std::ranges::all_of(letters, [](char c) { return c >= 'a' && c <= 'z'; }));
+}
+
+JOWI_ADD_TEST(test_random_fill_wide_reals_and_choices) {
+  std::vector<long double> reals(1000);
+  test_lib::random_fill(std::span{reals}, test_lib::UniformReal<long double>{0, 1});
+  test_lib::assert_true(std::ranges::all_of(reals, [](long double v) { return v >= 0 && v < 1; }));
+  test_lib::assert_true(std::ranges::adjacent_find(reals) == reals.end());
+  test_lib::assert_throw<std::invalid_argument>([]() {
+    test_lib::UniformChoice{std::string_view{}};
+  });
+}
+
+JOWI_ADD_TEST(test_workload_generators) {
+  auto zipf = test_lib::ZipfDistribution{1000, 1.1};
+  std::vector<size_t> counts(1000);
+  for (uint64_t rank : test_lib::random_view(zipf, 100000)) {
+    counts.at(rank) += 1;
+  }
+  test_lib::assert_true(counts[0] > counts[1] && counts[1] > counts[10]);
+  std::array<double, 3> weights{1.0, 0.0, 3.0};
+  auto table = test_lib::AliasTable{weights};
+  for (size_t i = 0; i < 1000; i += 1) {
+    test_lib::assert_not_equal(table(), 1);
+  }
+  auto sample = test_lib::random_sample(1'000'000, 1000);
+  test_lib::assert_equal(sample.size(), 1000);
+  test_lib::assert_true(std::ranges::adjacent_find(sample, std::greater_equal{}) == sample.end());
+  std::vector<int> sorted;
+  std::ranges::copy(test_lib::sorted_view(10000, -50, 50), std::back_inserter(sorted));
+  test_lib::assert_equal(sorted.size(), 10000);
+  test_lib::assert_true(std::ranges::is_sorted(sorted));
+  test_lib::assert_true(sorted.front() >= -50 && sorted.back() <= 50);
+}
+
 JOWI_ADD_TEST(test_assert_equal) {
   test_lib::assert_equal(1, 1);
   test_lib::assert_equal("asdf", "asdf");
@@ -53,6 +134,52 @@ JOWI_ADD_TEST(test_assert_equal_ranges) {
   test_lib::assert_equal(x, x);
 }
 
+JOWI_ADD_TEST(test_assert_equal_contiguous_ranges) {
+  std::vector<uint8_t> x(1000, 7);
+  std::vector<uint8_t> y = x;
+  test_lib::assert_equal(std::span{x}, std::span{y});
+  y[777] = 8;
+  auto failure = [](auto &&f) {
+    try {
+      f();
+    } catch (const test_lib::FailAssertion &e) {
+      return std::string{e.msg()};
+    }
+    return std::string{};
+  };
+  test_lib::assert_true(
+    failure([&]() { test_lib::assert_equal(std::span{x}, std::span{y}); }).ends_with("index 777")
+  );
+  y.pop_back();
+  test_lib::assert_true(
+    failure([&]() { test_lib::assert_equal(std::span{x}, std::span{y}); }).contains("sizes")
+  );
+  auto unsized = std::views::iota(0) | std::views::take_while([](int v) { return v < 2; });
+  test_lib::assert_true(
+    failure([&]() { test_lib::assert_equal(std::vector{0, 1, 2}, unsized); }).contains("sizes")
+  );
+}
+
+JOWI_ADD_TEST(test_assert_equal_collect_mismatches) {
+  std::vector<int> x(100000, 1);
+  std::vector<int> y = x;
+  test_lib::assert_equal(x, y, test_lib::CollectMismatches{});
+  for (size_t i = 0; i < y.size(); i += 7) {
+    y[i] = 2;
+  }
+  std::string msg;
+  try {
+    test_lib::assert_equal(x, y, test_lib::CollectMismatches{.keep = 2, .max_regions = 3});
+  } catch (const test_lib::FailAssertion &e) {
+    msg = e.msg();
+  }
+  test_lib::assert_true(msg.contains("14286 of 100000 elements do not match in 14286 regions"));
+  test_lib::assert_true(msg.contains("[0, 1) [7, 8) [14, 15) and 14283 more"));
+  test_lib::assert_true(msg.ends_with("index 99995 : 1 is not equal to 2"));
+  // The message does not grow with the amount of mismatches.
+  test_lib::assert_lt(msg.size(), size_t{1000});
+}
+
 JOWI_ADD_TEST(test_assert_lt_ranges) {
   std::array x = {1, 2, 3, 4, 5, 6};
   std::array y = {2, 3, 4, 5, 6, 7};
@@ -79,6 +206,48 @@ JOWI_ADD_TEST(test_assert_false) {
 
 JOWI_ADD_TEST(test_assert_close) {
   test_lib::assert_close(1.0, 1.005, 0.01);
+  test_lib::assert_close(1.0f, 1.0001f, test_lib::Tolerance::relative(1e-3));
+  test_lib::assert_close(0.0, -0.0, test_lib::Tolerance::ulps(0));
+  test_lib::assert_close(std::numeric_limits<double>::quiet_NaN(), std::nan(""));
+  test_lib::assert_close(1, 1.0000001);
+}
+
+JOWI_ADD_TEST(test_assert_close_ranges) {
+  std::vector<float> x(1000, 1.0f);
+  std::vector<float> y = x;
+  y[3] = std::nextafter(1.0f, 2.0f);
+  test_lib::assert_close(x, y, test_lib::Tolerance::ulps(1));
+  y[10] = 1.5f;
+  y[500] = std::numeric_limits<float>::infinity();
+  y[999] = 2.0f;
+  auto failure = [](auto &&f) {
+    try {
+      f();
+    } catch (const test_lib::FailAssertion &e) {
+      return std::string{e.msg()};
+    }
+    return std::string{};
+  };
+  auto msg = failure([&]() { test_lib::assert_close(x, y, test_lib::Tolerance::relative(0.1)); });
+  test_lib::assert_true(msg.contains("3 of 1000 elements"));
+  test_lib::assert_true(msg.contains("index 500"));
+  std::list<double> l(x.begin(), x.end());
+  msg = failure([&]() { test_lib::assert_close(l, y); });
+  test_lib::assert_true(msg.contains("3 of 1000 elements"));
+  test_lib::assert_true(msg.contains("index 500"));
+}
+
+JOWI_ADD_TEST(test_assert_close_special_lanes) {
+  std::vector<double> x(16, 1.0);
+  std::vector<double> y = x;
+  y[5] = std::numeric_limits<double>::quiet_NaN();
+  test_lib::assert_throw<test_lib::FailAssertion>([&]() {
+    test_lib::assert_close(x, y, test_lib::Tolerance::ulps(UINT64_MAX));
+  });
+  y[5] = std::numeric_limits<double>::infinity();
+  test_lib::assert_throw<test_lib::FailAssertion>([&]() {
+    test_lib::assert_close(x, y, std::numeric_limits<double>::infinity());
+  });
 }
 
 JOWI_ADD_TEST(test_assert_expected) {
@@ -89,4 +258,28 @@ JOWI_ADD_TEST(test_assert_expected) {
 JOWI_ADD_TEST(test_assert_throw) {
   test_lib::assert_throw([]() { throw std::runtime_error{""}; });
   test_lib::assert_throw<test_lib::FailAssertion>([]() { throw test_lib::FailAssertion(""); });
-}
\ No newline at end of file
+}
+
+JOWI_ADD_TEST(test_assert_no_alloc) {
+  std::array<int, 16> x{};
+  test_lib::assert_no_alloc([&]() { std::ranges::fill(x, 1); });
+  test_lib::assert_throw<test_lib::FailAssertion>([]() {
+    test_lib::assert_no_alloc([]() { test_lib::do_not_optimize(std::make_unique<int>(1)); });
+  });
+}
+
+JOWI_ADD_TEST(test_assert_max_allocs) {
+  test_lib::assert_max_allocs(2, []() {
+    auto v = std::vector<int>{};
+    v.reserve(32);
+    test_lib::do_not_optimize(v);
+  });
+  test_lib::assert_throw<test_lib::FailAssertion>([]() {
+    test_lib::assert_max_allocs(1, []() {
+      auto a = std::make_unique<int>(1);
+      auto b = std::make_unique<int>(2);
+      test_lib::do_not_optimize(a);
+      test_lib::do_not_optimize(b);
+    });
+  });
+}
@@ -1,7 +1,21 @@
 #include <jowi/test_lib.hpp>
+#include <algorithm>
+#include <array>
 #include <chrono>
+#include <expected>
+#include <filesystem>
+#include <format>
+#include <fstream>
+#include <iterator>
+#include <memory_resource>
+#include <optional>
 #include <print>
+#include <span>
 #include <stdexcept>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <vector>
 import jowi.test_lib;
 
 namespace test_lib = jowi::test_lib;
@@ -27,29 +41,28 @@ JOWI_ADD_TEST(run_throw_runtime_error) {
 }
 
 JOWI_ADD_TEST(test_time_format) {
-  test_lib::TestTimeUnit prev_unit = test_lib::get_test_context().time_unit;
-  test_lib::get_test_context().time_unit = test_lib::TestTimeUnit::MICRO_SECONDS;
+  auto ctx = test_lib::TestContext{};
+  ctx.set_time_unit(test_lib::TestTimeUnit::MICRO_SECONDS);
   test_lib::assert_equal(
-    test_lib::get_test_context().get_time(
+    ctx.get_time(
       std::chrono::duration_cast<std::chrono::system_clock::duration>(std::chrono::microseconds{1})
     ),
     "1.00 μs"
   );
-  test_lib::get_test_context().time_unit = test_lib::TestTimeUnit::MILLI_SECONDS;
+  ctx.set_time_unit(test_lib::TestTimeUnit::MILLI_SECONDS);
   test_lib::assert_equal(
-    test_lib::get_test_context().get_time(
+    ctx.get_time(
       std::chrono::duration_cast<std::chrono::system_clock::duration>(std::chrono::milliseconds{1})
     ),
     "1.00 ms"
   );
-  test_lib::get_test_context().time_unit = test_lib::TestTimeUnit::SECONDS;
+  ctx.set_time_unit(test_lib::TestTimeUnit::SECONDS);
   test_lib::assert_equal(
-    test_lib::get_test_context().get_time(
+    ctx.get_time(
       std::chrono::duration_cast<std::chrono::system_clock::duration>(std::chrono::seconds{1})
     ),
     "1.00 s"
   );
-  test_lib::get_test_context().time_unit = prev_unit;
 }
 
 JOWI_SETUP(argc, argv) {
@@ -61,4 +74,496 @@ JOWI_SETUP(argc, argv) {
 */
 JOWI_TEARDOWN() {
   test_lib::get_test_context().thread_count = 0;
-}
\ No newline at end of file
+}
+
+JOWI_ADD_TEST(benchmark_stats_from_samples) {
+  auto stats = test_lib::BenchmarkStats::from_samples(10, {5.0, 1.0, 3.0, 2.0, 100.0});
+  test_lib::assert_equal(stats.iterations, 10);
+  test_lib::assert_equal(stats.min, 1.0);
+  test_lib::assert_equal(stats.median, 3.0);
+  test_lib::assert_equal(stats.mean, 22.2);
+  test_lib::assert_equal(stats.mad, 2.0);
+}
+
+JOWI_ADD_TEST(run_failing_benchmark) {
+  auto bench = test_lib::BenchmarkEntry{[]() { test_lib::assert_true(false); }};
+  auto res = bench.run_test();
+  test_lib::assert_true(res.is_error());
+  test_lib::assert_false(res.benchmark().has_value());
+}
+
+JOWI_ADD_BENCHMARK(bench_accumulate) {
+  std::array<int, 64> values{};
+  values.fill(1);
+  int sum = 0;
+  for (int v : values) {
+    sum += v;
+  }
+  test_lib::do_not_optimize(sum);
+}
+
+JOWI_ADD_TEST(baseline_detects_regression) {
+  auto baseline = test_lib::BaselineStore{};
+  baseline.set("bench", std::vector<double>{10, 11, 10, 12, 10, 11, 10, 11});
+  auto same = test_lib::TestResult{std::chrono::seconds{1}};
+  same.set_benchmark(test_lib::BenchmarkStats::from_samples(1, {10, 11, 11, 10, 12, 10, 10, 11}));
+  test_lib::assert_false(baseline.compare("bench", same).has_value());
+  auto slower = test_lib::TestResult{std::chrono::seconds{1}};
+  slower.set_benchmark(test_lib::BenchmarkStats::from_samples(1, {20, 21, 22, 20, 21, 20, 23, 21}));
+  test_lib::assert_true(baseline.compare("bench", slower).has_value());
+  test_lib::assert_false(baseline.compare("unknown", slower).has_value());
+}
+
+JOWI_ADD_TEST(runner_delivers_results_in_order) {
+  auto slow = test_lib::TestEntry{[]() {
+    std::this_thread::sleep_for(std::chrono::milliseconds{20});
+  }};
+  auto fast = test_lib::TestEntry{[]() {}};
+  std::array<const test_lib::GenericTestEntry *, 8> entries{
+    &slow, &fast, &fast, &slow, &fast, &fast, &fast, &slow
+  };
+  std::vector<size_t> delivered;
+  test_lib::TestRunner{4}.run(entries, [&](size_t slot, test_lib::TestResult &&) {
+    delivered.push_back(slot);
+  });
+  test_lib::assert_equal(delivered, std::vector<size_t>{0, 1, 2, 3, 4, 5, 6, 7});
+}
+
+JOWI_ADD_TEST(runner_checks_results_before_failing_fast) {
+  auto pass = test_lib::TestEntry{[]() {}};
+  std::array<const test_lib::GenericTestEntry *, 3> entries{&pass, &pass, &pass};
+  std::vector<size_t> failed;
+  test_lib::TestRunner{1, true}.run(
+    entries,
+    [&](size_t slot, test_lib::TestResult &&res) {
+      if (res.is_error()) {
+        failed.push_back(slot);
+      }
+    },
+    {},
+    {},
+    [](size_t, test_lib::TestResult &res) {
+      res.set_error(
+        test_lib::ExceptionInfo{std::string{test_lib::performance_regression}, "slower"}
+      );
+    }
+  );
+  test_lib::assert_equal(failed, std::vector<size_t>{0});
+}
+
+JOWI_ADD_TEST(run_records_resources) {
+  auto conf = test_lib::TestEntry{[]() {
+    volatile double x = 0;
+    for (int i = 0; i < 100000; i += 1) {
+      x = x + 1;
+    }
+  }};
+  auto res = conf.run_test();
+  test_lib::assert_true(res.resources().has_value());
+  test_lib::assert_true(res.resources()->user_time.count() >= 0);
+  test_lib::assert_true(res.resources()->minor_faults >= 0);
+}
+
+JOWI_ADD_TEST(perf_counters_degrade_gracefully) {
+  auto group = test_lib::PerfCounterGroup{};
+  group.start();
+  auto counters = group.stop();
+  if (!group.available()) {
+    test_lib::assert_false(counters.cycles.has_value());
+    test_lib::assert_false(counters.ipc().has_value());
+  }
+}
+
+JOWI_ADD_TEST(run_measures_test_arena) {
+  auto used = test_lib::test_arena().used();
+  auto conf = test_lib::TestEntry{[]() {
+    std::pmr::vector<int> v{&test_lib::get_test_context().arena()};
+    v.resize(1000);
+  }};
+  auto res = conf.run_test();
+  test_lib::assert_true(res.arena_high_water_mark() >= 1000 * sizeof(int));
+  test_lib::assert_equal(test_lib::test_arena().used() - used, res.arena_high_water_mark());
+}
+
+JOWI_ADD_TEST(nested_run_keeps_the_enclosing_arena) {
+  std::pmr::vector<int> outer{&test_lib::test_arena()};
+  outer.assign(1000, 7);
+  auto res = test_lib::TestEntry{[]() {
+    std::pmr::vector<int> inner{&test_lib::test_arena()};
+    inner.assign(1000, 9);
+  }}.run_test();
+  test_lib::assert_true(res.is_ok());
+  std::pmr::vector<int> after{&test_lib::test_arena()};
+  after.assign(1000, 3);
+  test_lib::assert_true(std::ranges::all_of(outer, [](int v) { return v == 7; }));
+}
+
+JOWI_ADD_TEST(nested_run_keeps_the_enclosing_generator) {
+  auto expected = test_lib::thread_generator();
+  auto res = test_lib::TestEntry{[]() { test_lib::random_integer(0, 100); }}.run_test();
+  test_lib::assert_true(res.is_ok());
+  test_lib::assert_equal(test_lib::thread_generator().gen(), expected.gen());
+}
+
+std::string read_file(const std::filesystem::path &path) {
+  std::ifstream f{path};
+  return std::string{std::istreambuf_iterator<char>{f}, std::istreambuf_iterator<char>{}};
+}
+
+JOWI_ADD_TEST(junit_report_is_well_formed_while_running) {
+  auto path = std::filesystem::temp_directory_path() /
+    std::format("jowi_junit_{}.xml", test_lib::random_string(12));
+  {
+    auto reporter =
+      test_lib::JUnitReporter{test_lib::BufferedWriter::open(path).value(), "suite<1>"};
+    reporter.run_started(2);
+    auto content = read_file(path);
+    test_lib::assert_true(content.ends_with("  </testsuite>\n</testsuites>\n"));
+    reporter.test_finished(0, "passing", test_lib::TestResult{std::chrono::milliseconds{1}});
+    reporter.test_skipped(1, "skipped");
+    reporter.run_finished(test_lib::RunSummary{1, 0, 1, std::chrono::milliseconds{1}, {}});
+  }
+  auto content = read_file(path);
+  std::filesystem::remove(path);
+  test_lib::assert_true(content.contains(R"(<testsuite name="suite&lt;1&gt;" tests="2")"));
+  test_lib::assert_true(content.contains(R"(<testcase name="passing")"));
+  test_lib::assert_true(content.contains("<skipped/>"));
+  test_lib::assert_true(content.ends_with("  </testsuite>\n</testsuites>\n"));
+}
+
+JOWI_ADD_TEST(jsonl_report_escapes_strings) {
+  auto path = std::filesystem::temp_directory_path() /
+    std::format("jowi_jsonl_{}.jsonl", test_lib::random_string(12));
+  {
+    auto reporter = test_lib::JsonLinesReporter{test_lib::BufferedWriter::open(path).value()};
+    auto res = test_lib::TestResult{std::chrono::milliseconds{1}};
+    res.set_error(test_lib::ExceptionInfo{"error", "line \"one\"\nline two"});
+    reporter.test_finished(3, "failing", res);
+  }
+  auto content = read_file(path);
+  std::filesystem::remove(path);
+  test_lib::assert_equal(
+    content,
+    std::string{
+      R"({"event":"test","index":3,"name":"failing","status":"error","duration_ns":1000000,)"
+      R"("error":{"name":"error","message":"line \"one\"\nline two"}})"
+      "\n"
+    }
+  );
+}
+
+struct CountingListener : public test_lib::TestListener {
+  std::vector<size_t> finished;
+  size_t started = 0;
+  size_t assertions = 0;
+  size_t summaries = 0;
+
+  void test_started(size_t index, std::string_view name) override {
+    started += 1;
+  }
+  void assertion_failed(size_t index, std::string_view name, const test_lib::ExceptionInfo &e)
+    override {
+    assertions += 1;
+  }
+  void test_finished(size_t index, std::string_view name, const test_lib::TestResult &res)
+    override {
+    finished.push_back(index);
+  }
+  void run_finished(const test_lib::RunSummary &summary) override {
+    summaries += 1;
+  }
+};
+
+JOWI_ADD_TEST(event_bus_delivers_every_event) {
+  auto listener = CountingListener{};
+  std::array<test_lib::TestListener *, 1> listeners{&listener};
+  {
+    auto bus = test_lib::EventBus{listeners};
+    std::vector<std::jthread> producers;
+    for (size_t t = 0; t < 4; t += 1) {
+      producers.emplace_back([&bus, t]() {
+        for (size_t i = t; i < 400; i += 4) {
+          bus.test_started(i, "test");
+        }
+      });
+    }
+    producers.clear();
+    auto err = test_lib::ExceptionInfo{test_lib::FailAssertion{"failed"}};
+    for (size_t i = 0; i < 400; i += 1) {
+      bus.test_finished(i, "test", test_lib::TestResult{std::chrono::microseconds{1}, err});
+    }
+    bus.run_finished(test_lib::RunSummary{0, 400, 0, std::chrono::nanoseconds{0}, {}});
+  }
+  test_lib::assert_equal(listener.started, 400);
+  test_lib::assert_equal(listener.assertions, 400);
+  test_lib::assert_equal(listener.summaries, 1);
+  test_lib::assert_equal(listener.finished.size(), 400);
+  test_lib::assert_true(std::ranges::is_sorted(listener.finished));
+}
+
+JOWI_ADD_TEST(filter_matches_names_globs_and_regexes) {
+  auto suite = test_lib::TestSuite{};
+  suite.add_test([]() {}, "Math.add")
+    .add_test([]() {}, "Math.sub")
+    .add_test([]() {}, "String.split")
+    .add_test([]() {}, "String.join_3");
+  test_lib::assert_equal(suite.find("String.split").value(), 2);
+  test_lib::assert_false(suite.find("String").has_value());
+
+  auto filter = test_lib::TestFilter{};
+  test_lib::assert_true(filter.add("Math.*").has_value());
+  test_lib::assert_true(filter.add("re:String\\.join_[0-9]+").has_value());
+  test_lib::assert_false(filter.add("re:(").has_value());
+  test_lib::assert_equal(filter.select(suite), std::vector<size_t>{0, 1, 3});
+  test_lib::assert_equal(filter.select(suite, false), std::vector<size_t>{2});
+
+  auto glob = test_lib::TestFilter{};
+  glob.add("*.s[!p]?");
+  glob.add("String.split");
+  test_lib::assert_equal(glob.select(suite), std::vector<size_t>{1, 2});
+}
+
+JOWI_ADD_TEST(shard_parse) {
+  auto shard = test_lib::TestShard::parse("1/3");
+  test_lib::assert_true(shard.has_value());
+  test_lib::assert_equal(shard->index, 1);
+  test_lib::assert_equal(shard->count, 3);
+  for (std::string_view invalid : {"", "1", "1/", "/3", "3/3", "0/0", "-1/3", "a/3", "1/3x"}) {
+    test_lib::assert_false(test_lib::TestShard::parse(invalid).has_value());
+  }
+}
+
+JOWI_ADD_TEST(shard_deals_tests_round_robin) {
+  std::array<std::string_view, 7> names{"a", "b", "c", "d", "e", "f", "g"};
+  test_lib::assert_equal(test_lib::TestShard{0, 3}.select(names), std::vector<size_t>{0, 3, 6});
+  test_lib::assert_equal(test_lib::TestShard{1, 3}.select(names), std::vector<size_t>{1, 4});
+  test_lib::assert_equal(test_lib::TestShard{2, 3}.select(names), std::vector<size_t>{2, 5});
+}
+
+JOWI_ADD_TEST(shard_balances_longest_tests_first) {
+  std::array<std::string_view, 5> names{"a", "b", "c", "d", "e"};
+  auto durations = test_lib::DurationStore{};
+  durations.set("a", std::chrono::nanoseconds{100});
+  durations.set("b", std::chrono::nanoseconds{60});
+  durations.set("c", std::chrono::nanoseconds{50});
+  durations.set("d", std::chrono::nanoseconds{40});
+  // e takes the median, 60 : a goes to 0, b and e to 1, c to 0 and d to 1.
+  test_lib::assert_equal(
+    test_lib::TestShard{0, 2}.select(names, durations), std::vector<size_t>{0, 2}
+  );
+  test_lib::assert_equal(
+    test_lib::TestShard{1, 2}.select(names, durations), std::vector<size_t>{1, 3, 4}
+  );
+}
+
+JOWI_ADD_TEST(shards_agree_on_the_partition_of_a_shared_history) {
+  auto path = std::filesystem::temp_directory_path() /
+    std::format("jowi_durations_{}", test_lib::random_string(12));
+  std::vector<std::string> owned;
+  auto history = test_lib::DurationStore{};
+  for (int i = 0; i < 20; i += 1) {
+    owned.push_back(std::format("test_{}", i));
+    // The last tests have no record, they are assumed to take the median.
+    if (i < 15) {
+      history.set(owned.back(), std::chrono::milliseconds{(i * 7) % 11 + 1});
+    }
+  }
+  test_lib::DurationStore{}.commit(path, history);
+  std::vector<std::string_view> names{owned.begin(), owned.end()};
+  std::vector<int> runs(names.size(), 0);
+  for (size_t index = 0; index < 3; index += 1) {
+    // Every shard reads the history on its own.
+    auto durations = test_lib::DurationStore::load(path);
+    for (size_t pos : test_lib::TestShard{index, 3}.select(names, durations)) {
+      runs[pos] += 1;
+    }
+  }
+  std::filesystem::remove(path);
+  test_lib::assert_true(std::ranges::all_of(runs, [](int r) { return r == 1; }));
+}
+
+JOWI_ADD_TEST(duration_store_load_skips_malformed_lines) {
+  auto path = std::filesystem::temp_directory_path() /
+    std::format("jowi_durations_{}", test_lib::random_string(12));
+  std::ofstream{path} << "100 a\nnot a record\n300 a\n-5 b\n7 \n50 c d\n";
+  auto store = test_lib::DurationStore::load(path);
+  std::filesystem::remove(path);
+  test_lib::assert_equal(store.size(), 2);
+  test_lib::assert_true(store.get("a") == std::chrono::nanoseconds{200});
+  test_lib::assert_true(store.get("c d") == std::chrono::nanoseconds{50});
+  test_lib::assert_false(store.get("b").has_value());
+}
+
+JOWI_ADD_TEST(duration_store_commit_appends_then_compacts) {
+  auto path = std::filesystem::temp_directory_path() /
+    std::format("jowi_durations_{}", test_lib::random_string(12));
+  auto store = test_lib::DurationStore::load(path);
+  store.commit(path, test_lib::DurationStore{}.set("a", std::chrono::nanoseconds{10}));
+  test_lib::assert_equal(read_file(path), "10 a\n");
+  for (int i = 0; i < 100; i += 1) {
+    store.commit(path, test_lib::DurationStore{}.set("a", std::chrono::nanoseconds{i}));
+  }
+  auto lines = std::ranges::count(read_file(path), '\n');
+  auto reloaded = test_lib::DurationStore::load(path);
+  std::filesystem::remove(path);
+  test_lib::assert_true(lines < 100);
+  test_lib::assert_true(reloaded.get("a") == store.get("a"));
+}
+
+JOWI_ADD_TEST(longest_first_puts_unknown_tests_first) {
+  std::array<std::string_view, 4> names{"a", "b", "c", "d"};
+  auto durations = test_lib::DurationStore{};
+  durations.set("a", std::chrono::nanoseconds{10});
+  durations.set("c", std::chrono::nanoseconds{30});
+  durations.set("d", std::chrono::nanoseconds{30});
+  test_lib::assert_equal(durations.longest_first(names), std::vector<size_t>{1, 2, 3, 0});
+}
+
+JOWI_ADD_TEST(fail_fast_cancels_tests_not_started) {
+  auto fail = test_lib::TestEntry{[]() { throw std::runtime_error{"fail"}; }};
+  auto slow = test_lib::TestEntry{[]() {
+    std::this_thread::sleep_for(std::chrono::milliseconds{20});
+  }};
+  std::array<const test_lib::GenericTestEntry *, 8> entries{
+    &fail, &slow, &slow, &slow, &slow, &slow, &slow, &slow
+  };
+  std::vector<size_t> delivered;
+  test_lib::TestRunner{2, true}.run(entries, [&](size_t slot, test_lib::TestResult &&) {
+    delivered.push_back(slot);
+  });
+  test_lib::assert_true(delivered.size() < entries.size());
+  test_lib::assert_equal(delivered.front(), 0);
+}
+
+JOWI_ADD_TEST(static_registration_records_location) {
+  const auto &entry = test_lib::get_test_context().tests.get(0).value().get();
+  const auto *static_entry = dynamic_cast<const test_lib::StaticTestEntry *>(&entry);
+  test_lib::assert_true(static_entry != nullptr);
+  test_lib::assert_equal(static_entry->name(), "create_with_struct_name");
+  auto file = std::string_view{static_entry->location().file_name()};
+  test_lib::assert_true(file.ends_with("tests.cc"));
+}
+
+JOWI_ADD_TEST(static_benchmark_registration_records_location) {
+  const auto &entry = test_lib::get_test_context().tests.get("bench_accumulate").value().get();
+  const auto *static_entry = dynamic_cast<const test_lib::StaticBenchmarkEntry *>(&entry);
+  test_lib::assert_true(static_entry != nullptr);
+  auto file = std::string_view{static_entry->location().file_name()};
+  test_lib::assert_true(file.ends_with("tests.cc"));
+}
+
+struct BaseError : public std::runtime_error {
+  using std::runtime_error::runtime_error;
+};
+struct DerivedError : public BaseError {
+  using BaseError::BaseError;
+};
+
+JOWI_ADD_TEST(run_translates_custom_exceptions) {
+  auto conf = test_lib::TestEntry{
+    []() { throw DerivedError{"derived"}; },
+    "custom_exceptions",
+    test_lib::ExceptionPack<BaseError, DerivedError>{}
+  };
+  auto res = conf.run_test();
+  test_lib::assert_equal(res.get_error().value().name, "DerivedError");
+  test_lib::assert_equal(res.get_error().value().message, "derived");
+  auto logic = test_lib::TestEntry{[]() { throw std::logic_error{"logic"}; }}.run_test();
+  test_lib::assert_equal(logic.get_error().value().name, "std::exception");
+}
+
+JOWI_ADD_TEST(expectations_fail_after_the_test_returns) {
+  size_t checked = 0;
+  auto entry = test_lib::TestEntry{[&]() {
+    for (int i = 0; i < 100; i += 1) {
+      test_lib::expect_lt(i, 60);
+      checked += 1;
+    }
+    test_lib::expect_true(true);
+  }};
+  auto res = entry.run_test();
+  test_lib::assert_equal(checked, size_t{100});
+  test_lib::assert_true(res.is_error());
+  test_lib::assert_true(res.get_error()->name.ends_with("FailAssertion"));
+  auto msg = res.get_error()->message;
+  test_lib::assert_true(msg.starts_with("40 expectations failed"));
+  test_lib::assert_true(msg.contains("60 is not less than 60"));
+  test_lib::assert_true(msg.ends_with("... 8 more"));
+  test_lib::expect_equal(test_lib::TestEntry{[]() {}}.run_test().is_ok(), true);
+}
+
+JOWI_ADD_TEST(benchmark_fails_on_failed_expectations) {
+  auto res = test_lib::BenchmarkEntry{[]() { test_lib::expect_true(false); }}.run_test();
+  test_lib::assert_true(res.is_error());
+  test_lib::assert_true(res.get_error()->name.ends_with("FailAssertion"));
+  test_lib::assert_true(test_lib::TestEntry{[]() {}}.run_test().is_ok());
+}
+
+JOWI_ADD_TEST_RESULT(test_returns_expected, std::expected<void, std::string>) {
+  auto v = std::vector{3, 1, 2};
+  std::ranges::sort(v);
+  if (!std::ranges::is_sorted(v)) {
+    return std::unexpected{"sort left the vector unsorted"};
+  }
+  return {};
+}
+
+JOWI_ADD_TEST(returned_errors_fail_without_throwing) {
+  auto returns_false = test_lib::TestEntry{[]() { return false; }}.run_test();
+  test_lib::assert_true(returns_false.get_error()->name.ends_with("FailAssertion"));
+  auto unexpected =
+    test_lib::TestEntry{[]() -> std::expected<void, int> { return std::unexpected{42}; }}
+      .run_test();
+  test_lib::assert_equal(unexpected.get_error()->message, "42");
+  auto info = test_lib::TestEntry{[]() -> std::optional<test_lib::ExceptionInfo> {
+                return test_lib::ExceptionInfo{"ParseError", "bad header"};
+              }}.run_test();
+  test_lib::assert_equal(info.get_error()->name, "ParseError");
+  test_lib::assert_true(test_lib::TestEntry{[]() { return true; }}.run_test().is_ok());
+}
+
+JOWI_ADD_PROPERTY(
+  reverse_twice_is_identity, test_lib::vectors_of(test_lib::integers(-100, 100), 0, 50)
+)(const std::vector<int> &v) {
+  auto reversed = v;
+  std::ranges::reverse(reversed);
+  std::ranges::reverse(reversed);
+  test_lib::assert_equal(reversed, v);
+}
+
+JOWI_ADD_TEST(property_shrinks_counterexample) {
+  auto entry = test_lib::TestEntry{[]() {
+    test_lib::check_property(
+      [](int x, const std::vector<int> &v) { test_lib::assert_true(x < 1000 || v.size() < 3); },
+      test_lib::integers(0, 100000),
+      test_lib::vectors_of(test_lib::integers(0, 100), 0, 20)
+    );
+  }};
+  auto res = entry.run_test();
+  test_lib::assert_true(res.is_error());
+  test_lib::assert_true(res.get_error()->message.contains("shrunk"));
+  test_lib::assert_true(res.get_error()->message.contains(": 1000, [0, 0, 0]"));
+}
+
+JOWI_ADD_FUZZ(shard_parse_never_throws)(std::span<const std::byte> data) {
+  test_lib::TestShard::parse(
+    std::string_view{reinterpret_cast<const char *>(data.data()), data.size()}
+  );
+}
+
+JOWI_ADD_TEST(fuzz_writes_failing_inputs) {
+  auto config = test_lib::FuzzConfig{
+    .corpus = std::filesystem::temp_directory_path() /
+      std::format("jowi_corpus_{}", test_lib::random_string(12)),
+    .runs = 10000
+  };
+  auto entry = test_lib::FuzzEntry{"long_inputs_fail", [](std::span<const std::byte> data) {
+    test_lib::assert_true(data.size() < 4);
+  }};
+  auto report = entry.fuzz(config);
+  test_lib::assert_true(report.failure.has_value());
+  test_lib::assert_true(std::filesystem::exists(report.failure->input));
+  test_lib::assert_true(report.failure->input.filename().string().starts_with("crash-"));
+  test_lib::assert_throw<test_lib::FailAssertion>([&]() { entry.replay(config); });
+  std::filesystem::remove_all(config.corpus);
+}